@@ -19,6 +19,7 @@
 
 #include "pugl/cairo.h"
 #include "pugl/pugl.h"
+#include "pugl/pugl.hpp"
 
 namespace pugl {
 
@@ -36,6 +37,26 @@ cairoBackend() noexcept
   return puglCairoBackend();
 }
 
+/// @copydoc puglCairoShmBackend
+inline const PuglBackend*
+cairoShmBackend() noexcept
+{
+  return puglCairoShmBackend();
+}
+
+/// @copydoc PuglCairoTileFunc
+using CairoTileFunc = PuglCairoTileFunc;
+
+/// @copydoc puglSetCairoTileFunc
+inline Status
+setCairoTileFunc(View&         view,
+                 CairoTileFunc tileFunc,
+                 unsigned      numThreads) noexcept
+{
+  return static_cast<Status>(
+    puglSetCairoTileFunc(view.cobj(), tileFunc, numThreads));
+}
+
 /**
    @}
 */
@@ -54,6 +54,34 @@ leaveContext(View& view) noexcept
   return static_cast<Status>(puglLeaveContext(view.cobj()));
 }
 
+/// @copydoc puglReadPixels
+inline Status
+readPixels(View& view, void* const pixels, const size_t stride) noexcept
+{
+  return static_cast<Status>(puglReadPixels(view.cobj(), pixels, stride));
+}
+
+/// @copydoc puglStartCapture
+inline Status
+startCapture(View& view, const PuglGlCaptureFunc func) noexcept
+{
+  return static_cast<Status>(puglStartCapture(view.cobj(), func));
+}
+
+/// @copydoc puglStopCapture
+inline Status
+stopCapture(View& view) noexcept
+{
+  return static_cast<Status>(puglStopCapture(view.cobj()));
+}
+
+/// @copydoc puglGetFrameStats
+inline Status
+getFrameStats(const View& view, PuglGlFrameStats& stats) noexcept
+{
+  return static_cast<Status>(puglGetFrameStats(view.cobj(), &stats));
+}
+
 /// @copydoc puglGlBackend
 inline const PuglBackend*
 glBackend() noexcept
@@ -61,6 +89,13 @@ glBackend() noexcept
   return puglGlBackend();
 }
 
+/// @copydoc puglEglBackend
+inline const PuglBackend*
+eglBackend() noexcept
+{
+  return puglEglBackend();
+}
+
 /**
    @}
 */
@@ -0,0 +1,56 @@
+/*
+  Copyright 2012-2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef PUGL_PIXEL_HPP
+#define PUGL_PIXEL_HPP
+
+#include "pugl/pixel.h"
+#include "pugl/pugl.h"
+
+namespace pugl {
+
+/**
+   @defgroup pixelxx Pixel
+   Software drawing support.
+   @ingroup puglxx
+   @{
+*/
+
+/// @copydoc PuglPixelFormat
+enum class PixelFormat {
+  xrgb32, ///< @copydoc PUGL_PIXEL_XRGB32
+  argb32, ///< @copydoc PUGL_PIXEL_ARGB32
+};
+
+static_assert(PixelFormat(PUGL_PIXEL_ARGB32) == PixelFormat::argb32, "");
+
+/// @copydoc PuglPixelBuffer
+using PixelBuffer = PuglPixelBuffer;
+
+/// @copydoc puglPixelBackend
+inline const PuglBackend*
+pixelBackend() noexcept
+{
+  return puglPixelBackend();
+}
+
+/**
+   @}
+*/
+
+} // namespace pugl
+
+#endif // PUGL_PIXEL_HPP
@@ -228,13 +228,26 @@ static_assert(WorldType(PUGL_MODULE) == WorldType::module, "");
 
 /// @copydoc PuglWorldFlag
 enum class WorldFlag {
-  threads = PUGL_WORLD_THREADS, ///< @copydoc PUGL_WORLD_THREADS
+  threads  = PUGL_WORLD_THREADS,  ///< @copydoc PUGL_WORLD_THREADS
+  stats    = PUGL_WORLD_STATS,    ///< @copydoc PUGL_WORLD_STATS
+  headless = PUGL_WORLD_HEADLESS, ///< @copydoc PUGL_WORLD_HEADLESS
 };
 
-static_assert(WorldFlag(PUGL_WORLD_THREADS) == WorldFlag::threads, "");
+static_assert(WorldFlag(PUGL_WORLD_HEADLESS) == WorldFlag::headless, "");
 
 using WorldFlags = PuglWorldFlags; ///< @copydoc PuglWorldFlags
 
+using FdFlag  = PuglFdFlag;  ///< @copydoc PuglFdFlag
+using FdFlags = PuglFdFlags; ///< @copydoc PuglFdFlags
+using FdFunc  = PuglFdFunc;  ///< @copydoc PuglFdFunc
+
+using ReplayFlag  = PuglReplayFlag;  ///< @copydoc PuglReplayFlag
+using ReplayFlags = PuglReplayFlags; ///< @copydoc PuglReplayFlags
+
+using WorldStats = PuglWorldStats; ///< @copydoc PuglWorldStats
+using TracePhase = PuglTracePhase; ///< @copydoc PuglTracePhase
+using TraceFunc  = PuglTraceFunc;  ///< @copydoc PuglTraceFunc
+
 #if defined(PUGL_HPP_THROW_FAILED_CONSTRUCTION)
 
 /// An exception thrown when construction fails
@@ -321,6 +334,63 @@ public:
   {
     return static_cast<Status>(puglUpdate(cobj(), timeout));
   }
+
+  /// @copydoc puglRegisterFd
+  Status registerFd(const int     fd,
+                    const FdFlags flags,
+                    const FdFunc  func,
+                    void* const   data) noexcept
+  {
+    return static_cast<Status>(puglRegisterFd(cobj(), fd, flags, func, data));
+  }
+
+  /// @copydoc puglUnregisterFd
+  Status unregisterFd(const int fd) noexcept
+  {
+    return static_cast<Status>(puglUnregisterFd(cobj(), fd));
+  }
+
+  /// @copydoc puglStartRecording
+  Status startRecording(const char* const path) noexcept
+  {
+    return static_cast<Status>(puglStartRecording(cobj(), path));
+  }
+
+  /// @copydoc puglStopRecording
+  Status stopRecording() noexcept
+  {
+    return static_cast<Status>(puglStopRecording(cobj()));
+  }
+
+  /// @copydoc puglReplay
+  Status replay(const char* const path, const ReplayFlags flags) noexcept
+  {
+    return static_cast<Status>(puglReplay(cobj(), path, flags));
+  }
+
+  /// @copydoc puglGetWorldStats
+  Status stats(WorldStats& stats) const noexcept
+  {
+    return static_cast<Status>(puglGetWorldStats(cobj(), &stats));
+  }
+
+  /// @copydoc puglSetTraceFunc
+  Status setTraceFunc(const TraceFunc traceFunc, void* const data) noexcept
+  {
+    return static_cast<Status>(puglSetTraceFunc(cobj(), traceFunc, data));
+  }
+
+  /// @copydoc puglStartTraceFile
+  Status startTraceFile(const char* const path) noexcept
+  {
+    return static_cast<Status>(puglStartTraceFile(cobj(), path));
+  }
+
+  /// @copydoc puglStopTraceFile
+  Status stopTraceFile() noexcept
+  {
+    return static_cast<Status>(puglStopTraceFile(cobj()));
+  }
 };
 
 /**
@@ -330,6 +400,7 @@ public:
 */
 
 using Backend    = PuglBackend;    ///< @copydoc PuglBackend
+using ViewStats  = PuglViewStats;  ///< @copydoc PuglViewStats
 using NativeView = PuglNativeView; ///< @copydoc PuglNativeView
 
 /// @copydoc PuglViewHint
@@ -350,9 +421,13 @@ enum class ViewHint {
   resizable,           ///< @copydoc PUGL_RESIZABLE
   ignoreKeyRepeat,     ///< @copydoc PUGL_IGNORE_KEY_REPEAT
   refreshRate,         ///< @copydoc PUGL_REFRESH_RATE
+  compressMotion,      ///< @copydoc PUGL_COMPRESS_MOTION
+  retainContents,      ///< @copydoc PUGL_RETAIN_CONTENTS
+  shareContext,        ///< @copydoc PUGL_SHARE_CONTEXT
+  stickyContext,       ///< @copydoc PUGL_STICKY_CONTEXT
 };
 
-static_assert(ViewHint(PUGL_REFRESH_RATE) == ViewHint::refreshRate, "");
+static_assert(ViewHint(PUGL_STICKY_CONTEXT) == ViewHint::stickyContext, "");
 
 using ViewHintValue = PuglViewHintValue; ///< @copydoc PuglViewHintValue
 
@@ -551,6 +626,30 @@ public:
     return static_cast<Status>(puglPostRedisplayRect(cobj(), rect));
   }
 
+  /// @copydoc puglPostEventFromThread
+  Status postEventFromThread(const PuglEvent& event) noexcept
+  {
+    return static_cast<Status>(puglPostEventFromThread(cobj(), &event));
+  }
+
+  /// @copydoc puglPostRedisplayFromThread
+  Status postRedisplayFromThread(const Rect rect) noexcept
+  {
+    return static_cast<Status>(puglPostRedisplayFromThread(cobj(), rect));
+  }
+
+  /// @copydoc puglGetExposeRects
+  const Rect* exposeRects(size_t& count) const noexcept
+  {
+    return puglGetExposeRects(cobj(), &count);
+  }
+
+  /// @copydoc puglGetViewStats
+  Status stats(ViewStats& stats) const noexcept
+  {
+    return static_cast<Status>(puglGetViewStats(cobj(), &stats));
+  }
+
   /**
      @}
      @name Interaction
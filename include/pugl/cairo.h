@@ -37,6 +37,58 @@ PUGL_CONST_API
 const PuglBackend*
 puglCairoBackend(void);
 
+/**
+   Cairo graphics backend accessor that draws to shared memory.
+
+   This is like puglCairoBackend(), but on X11 draws into an image in a shared
+   memory segment and uploads only the damaged rectangles to the window with
+   the MIT-SHM extension, which avoids sending pixels through the connection.
+   This falls back to the same behaviour as puglCairoBackend() if shared
+   memory is unsupported, for example with remote displays, and on other
+   platforms.
+*/
+PUGL_CONST_API
+const PuglBackend*
+puglCairoShmBackend(void);
+
+/**
+   Function to draw a tile of a view with Cairo.
+
+   This is called from several threads at once, so it must not modify any
+   shared state, or call any Pugl functions except puglGetHandle().
+
+   @param view The view being drawn.
+   @param cr Cairo context for drawing the tile, a `cairo_t*`.  This is set up
+   to draw in view coordinates, and clipped to the damaged part of the tile.
+   @param tile The area of the view covered by the tile.
+*/
+typedef void (*PuglCairoTileFunc)(PuglView* view, void* cr, PuglRect tile);
+
+/**
+   Enable drawing a view in tiles with a pool of threads.
+
+   When this is enabled, exposed areas are split into tiles which are drawn
+   with `tileFunc` in parallel.  The tiles are drawn before the expose event
+   is dispatched, and replace the damaged region, so the expose handler only
+   needs to draw anything that should be drawn on top of them.
+
+   This must be called after the view is realized with a Cairo backend.  It is
+   currently only supported on X11.
+
+   @param view The view to draw in tiles.
+   @param tileFunc Function to draw each tile, or null to disable tiling.
+   @param numThreads Number of threads to draw with, including the one that
+   handles events, or zero to use one per CPU.
+   @return #PUGL_FAILURE if tiled drawing is not supported for this view, or
+   #PUGL_UNKNOWN_ERROR if the threads could not be started, in which case
+   tiled drawing is disabled.
+*/
+PUGL_API
+PuglStatus
+puglSetCairoTileFunc(PuglView*         view,
+                     PuglCairoTileFunc tileFunc,
+                     unsigned          numThreads);
+
 /**
    @}
 */
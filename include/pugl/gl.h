@@ -89,15 +89,176 @@ PUGL_API
 PuglStatus
 puglLeaveContext(PuglView* view);
 
+/**
+   Read the pixels of the last frame drawn to a headless view.
+
+   This is used to get the result of drawing a view in a world created with
+   #PUGL_WORLD_HEADLESS, for example to save it as an image or compare it to
+   a reference.  The pixels are written as 8-bit RGBA, one row after another
+   from top to bottom, starting at `pixels`.
+
+   This is currently only supported on X11 with puglEglBackend().
+
+   @param view The view to read from.
+   @param pixels Buffer with room for `stride` times the view height bytes.
+   @param stride Distance between rows in bytes, which must be a multiple of
+   4, or zero for 4 times the view width.
+   @return #PUGL_UNSUPPORTED_TYPE if the view isn't headless, or
+   #PUGL_FAILURE if it isn't realized or the stride is invalid.
+*/
+PUGL_API
+PuglStatus
+puglReadPixels(PuglView* view, void* pixels, size_t stride);
+
+/**
+   A frame captured from a view.
+
+   The pixels are 8-bit RGBA, with rows from bottom to top as in OpenGL.
+*/
+typedef struct {
+  double      time;   ///< Time the frame was drawn, see puglGetTime()
+  unsigned    width;  ///< Width in pixels
+  unsigned    height; ///< Height in pixels
+  size_t      stride; ///< Distance between rows in bytes
+  const void* pixels; ///< Pixels, only valid during the call
+} PuglGlFrame;
+
+/**
+   Function called with a captured frame.
+
+   This is called from the event loop with the view's context current, and
+   must not draw, change the OpenGL state, or stop capture.
+*/
+typedef void (*PuglGlCaptureFunc)(PuglView* view, const PuglGlFrame* frame);
+
+/**
+   Start capturing every frame that is drawn to a view.
+
+   After each expose, the frame about to be presented is copied into one of a
+   few pixel buffer objects without waiting for drawing to finish.  The frame
+   is passed to `func` a few frames later, once the copy is complete and can
+   be read without stalling, so capturing costs little in the event loop.
+   Frames are always delivered in order.
+
+   The view must be realized, and the context must support OpenGL 3.2 or
+   sync objects and pixel buffer objects with extensions.  If capture is
+   already running, then this only replaces the function.
+
+   @return #PUGL_FAILURE if the view isn't realized, or
+   #PUGL_UNSUPPORTED_TYPE if the context doesn't support capture.
+*/
+PUGL_API
+PuglStatus
+puglStartCapture(PuglView* view, PuglGlCaptureFunc func);
+
+/**
+   Stop capturing frames from a view.
+
+   This waits for any frames that are still being copied and passes them to
+   the capture function, so every captured frame is delivered before this
+   returns.
+
+   @return #PUGL_FAILURE if capture isn't running.
+*/
+PUGL_API
+PuglStatus
+puglStopCapture(PuglView* view);
+
+/// Number of one millisecond bins in the frame interval histogram
+#define PUGL_GL_NUM_INTERVALS 64
+
+/**
+   Presentation statistics for a view.
+
+   Where the system can tell when frames actually reach the screen, times are
+   from the display driver and vertical retraces are counted exactly.
+   Otherwise, a frame is considered presented when the backend has finished
+   presenting it, and missed retraces are estimated from the
+   #PUGL_REFRESH_RATE hint and how long that took.  Either way, retraces are
+   only missed after a frame is swapped, not while the view is idle.
+
+   - X11: Precise with GLX if the GLX_OML_sync_control extension is
+     supported, and otherwise estimated.  With OML_sync_control, frames are
+     recorded once they have been shown, which is usually when the next frame
+     is presented.
+*/
+typedef struct {
+  uint64_t numFrames;       ///< Number of frames presented
+  double   lastPresentTime; ///< Time of the last frame, see puglGetTime()
+  int64_t  lastMsc;         ///< Retrace count at the last frame, or zero
+  int64_t  lastSbc;         ///< Swap count at the last frame, or zero
+  uint64_t missedVblanks;   ///< Retraces that were missed between frames
+  bool     precise;         ///< True if times are from the display driver
+
+  /**
+     Histogram of the intervals between frames.
+
+     Each element is the number of frames that were presented the given
+     number of milliseconds after the previous one, rounded down.  The last
+     element also counts all longer intervals.
+  */
+  uint64_t intervals[PUGL_GL_NUM_INTERVALS];
+} PuglGlFrameStats;
+
+/**
+   Get presentation statistics for a view.
+
+   Statistics are accumulated since the view was realized, and only collected
+   if the world was created with #PUGL_WORLD_STATS.
+
+   @return #PUGL_FAILURE if the view isn't realized, or the world was not
+   created with #PUGL_WORLD_STATS.
+*/
+PUGL_API
+PuglStatus
+puglGetFrameStats(const PuglView* view, PuglGlFrameStats* stats);
+
 /**
    OpenGL graphics backend.
 
    Pass the returned value to puglSetBackend() to draw to a view with OpenGL.
+
+   If the #PUGL_SHARE_CONTEXT hint is set, then the context shares objects
+   like textures, buffers, and shaders with the contexts of all other views in
+   the world that set it.  Shared objects live until the world is freed, so
+   they only need to be created once, and can be reused by later views.  This
+   is currently only supported on X11, and the hint is set to false after the
+   view is realized if sharing wasn't possible.
+
+   If the #PUGL_STICKY_CONTEXT hint is set, then the context is left current
+   after drawing or puglLeaveContext(), and is only switched when another
+   view's context is entered.  This avoids expensive context switches when
+   the same view is entered many times in a row, but means that the context
+   of some view may be current in the calling thread at any time.  This is
+   currently only supported on X11.
 */
 PUGL_CONST_API
 const PuglBackend*
 puglGlBackend(void);
 
+/**
+   OpenGL graphics backend using EGL.
+
+   This is an alternative to puglGlBackend() on X11 that sets up OpenGL with
+   EGL instead of GLX, and can be chosen at runtime when both are available.
+   It supports the same hints.  With #PUGL_RETAIN_CONTENTS, buffers are
+   always swapped, so the whole view is exposed unless the driver supports
+   `EGL_EXT_buffer_age`, and only the damaged region is presented if it
+   supports `EGL_KHR_swap_buffers_with_damage`.
+
+   This backend can also draw views in a world created with
+   #PUGL_WORLD_HEADLESS, where it renders to an offscreen pbuffer surface
+   with no X server, using the Mesa surfaceless platform if it is available.
+   Headless views are always single buffered.
+
+   This backend is only available on X11 if pugl was built with EGL.
+
+   @return The EGL backend, or null if it isn't supported.
+*/
+PUGL_CONST_API
+const PuglBackend*
+puglEglBackend(void);
+
 PUGL_END_DECLS
 
 /**
@@ -0,0 +1,75 @@
+/*
+  Copyright 2019-2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef PUGL_PIXEL_H
+#define PUGL_PIXEL_H
+
+#include "pugl/pugl.h"
+
+#include <stddef.h>
+
+PUGL_BEGIN_DECLS
+
+/**
+   @defgroup pixel Pixel
+   Software drawing support.
+   @ingroup pugl
+   @{
+*/
+
+/// Format of pixels in a buffer
+typedef enum {
+  PUGL_PIXEL_XRGB32, ///< Native 32-bit words with 8-bit RGB and unused top
+  PUGL_PIXEL_ARGB32, ///< Native 32-bit words with 8-bit premultiplied ARGB
+} PuglPixelFormat;
+
+/**
+   A buffer of pixels for drawing a view.
+
+   A pointer to this is the context returned by puglGetContext() while
+   handling a #PUGL_EXPOSE event.  The buffer covers the whole view, but only
+   the damaged region is shown, so the view must draw everything in that
+   region.  Pixels outside of it are undefined, since there may be several
+   buffers that are used in turn.
+*/
+typedef struct {
+  void*           data;   ///< Pointer to the top left pixel
+  size_t          stride; ///< Number of bytes between the starts of rows
+  unsigned        width;  ///< Width in pixels
+  unsigned        height; ///< Height in pixels
+  PuglPixelFormat format; ///< Format of pixels
+} PuglPixelBuffer;
+
+/**
+   Pixel buffer graphics backend accessor.
+
+   Pass the returned value to puglSetBackend() to draw to a view by writing
+   pixels directly.  On X11, the buffers are in shared memory if possible, and
+   only the damaged region is sent to the server.
+
+   This backend is currently only available on X11.
+*/
+PUGL_CONST_API
+const PuglBackend*
+puglPixelBackend(void);
+
+/**
+   @}
+*/
+
+PUGL_END_DECLS
+
+#endif // PUGL_PIXEL_H
@@ -316,6 +316,18 @@ typedef PuglEventAny PuglEventUpdate;
    When an expose event is received, the graphics context is active, and the
    view must draw the entire specified region.  The contents of the region are
    undefined, there is no preservation of anything drawn previously.
+
+   The exception is if the #PUGL_RETAIN_CONTENTS hint is set and the backend
+   supports it, currently Cairo and OpenGL on X11.  Then, drawing is clipped to
+   the damaged region, everything else keeps the contents of the previous
+   frame, and areas that the system needs redrawn, for example when the window
+   is uncovered, are restored from those contents without an expose event.
+   The whole view is exposed when the contents are lost, for example on resize.
+
+   With OpenGL, drawing is clipped with the scissor box.  If the driver can't
+   present part of the back buffer, then buffers are swapped, and the damaged
+   region also includes anything drawn since the new back buffer was last
+   shown, so it may be larger than what was posted for redisplay.
 */
 typedef struct {
   PuglEventType  type;   ///< #PUGL_EXPOSE
@@ -439,16 +451,23 @@ typedef struct {
 
 /**
    Pointer motion event.
+
+   If the #PUGL_COMPRESS_MOTION hint is set, consecutive motion events may be
+   merged into one which has the latest position, in which case `count` is the
+   number of system events it represents and `firstTime` is the time of the
+   earliest one.  Otherwise, `count` is 1 and `firstTime` is equal to `time`.
 */
 typedef struct {
-  PuglEventType  type;  ///< #PUGL_MOTION
-  PuglEventFlags flags; ///< Bitwise OR of #PuglEventFlag values
-  double         time;  ///< Time in seconds
-  double         x;     ///< View-relative X coordinate
-  double         y;     ///< View-relative Y coordinate
-  double         xRoot; ///< Root-relative X coordinate
-  double         yRoot; ///< Root-relative Y coordinate
-  PuglMods       state; ///< Bitwise OR of #PuglMod flags
+  PuglEventType  type;      ///< #PUGL_MOTION
+  PuglEventFlags flags;     ///< Bitwise OR of #PuglEventFlag values
+  double         time;      ///< Time in seconds
+  double         x;         ///< View-relative X coordinate
+  double         y;         ///< View-relative Y coordinate
+  double         xRoot;     ///< Root-relative X coordinate
+  double         yRoot;     ///< Root-relative Y coordinate
+  PuglMods       state;     ///< Bitwise OR of #PuglMod flags
+  double         firstTime; ///< Time of first merged event in seconds
+  uint32_t       count;     ///< Number of merged events
 } PuglEventMotion;
 
 /**
@@ -631,9 +650,37 @@ typedef enum {
   /**
      Set up support for threads if necessary.
 
+     This is required to use puglPostEventFromThread() and
+     puglPostRedisplayFromThread().
+
      - X11: Calls XInitThreads() which is required for some drivers.
   */
-  PUGL_WORLD_THREADS = 1u << 0u
+  PUGL_WORLD_THREADS = 1u << 0u,
+
+  /**
+     Collect performance statistics.
+
+     This enables the counters returned by puglGetWorldStats() and
+     puglGetViewStats().  Without this flag, no statistics are collected and
+     there is no overhead.
+  */
+  PUGL_WORLD_STATS = 1u << 1u,
+
+  /**
+     Run without a display.
+
+     Views in a headless world have no window, and are drawn offscreen by the
+     backend whenever they are shown and have been exposed.  There is no
+     input, so only timers, watched file descriptors, and redisplays wake up
+     the event loop.  This is useful for rendering images on servers, and for
+     testing and benchmarking drawing code.
+
+     Only some backends support headless views, see puglReadPixels().
+
+     - X11: The X display is not opened, so this works with no X server.
+     - MacOS, Windows: Not supported, puglNewWorld() returns null.
+  */
+  PUGL_WORLD_HEADLESS = 1u << 2u
 } PuglWorldFlag;
 
 /// Bitwise OR of #PuglWorldFlag values
@@ -675,7 +722,7 @@ puglGetWorldHandle(PuglWorld* world);
 /**
    Return a pointer to the native handle of the world.
 
-   X11: Returns a pointer to the `Display`.
+   X11: Returns a pointer to the `Display`, or null for a headless world.
 
    MacOS: Returns null.
 
@@ -735,6 +782,158 @@ PUGL_API
 PuglStatus
 puglUpdate(PuglWorld* world, double timeout);
 
+/// File descriptor condition flags
+typedef enum {
+  PUGL_FD_READ  = 1u << 0u, ///< Data is available to read
+  PUGL_FD_WRITE = 1u << 1u, ///< Data can be written without blocking
+  PUGL_FD_ERROR = 1u << 2u  ///< An error or hang up occurred
+} PuglFdFlag;
+
+/// Bitwise OR of #PuglFdFlag values
+typedef uint32_t PuglFdFlags;
+
+/**
+   A function called when a registered file descriptor is ready.
+
+   @param world The world that the descriptor is registered with.
+   @param fd The file descriptor.
+   @param flags The conditions that are ready, a bitwise OR of #PuglFdFlag.
+   @param data The user data given to puglRegisterFd().
+*/
+typedef void (*PuglFdFunc)(PuglWorld*  world,
+                           int         fd,
+                           PuglFdFlags flags,
+                           void*       data);
+
+/**
+   Register a file descriptor to be watched by the event loop.
+
+   This adds an application file descriptor, like a pipe, socket, or eventfd,
+   to the set that puglUpdate() waits on along with the window system.  When
+   `fd` is ready for any of the conditions in `flags`, `func` is called from
+   within puglUpdate(), which then returns as if an event was received.  This
+   makes it possible to wake up the main loop from other threads or processes
+   without sending messages via the window system.
+
+   The function must consume whatever made the descriptor ready (for example,
+   by reading the available data), otherwise it will be called again on the
+   next update.  If #PUGL_FD_ERROR is set, the descriptor should usually be
+   unregistered.
+
+   If `fd` is already registered, then its registration is replaced.
+
+   Currently only supported on X11.
+
+   @param world The world to watch the descriptor in.
+   @param fd The file descriptor to watch.
+   @param flags The conditions to watch for, #PUGL_FD_READ and/or
+   #PUGL_FD_WRITE.
+   @param func The function to call when the descriptor is ready.
+   @param data User data to pass to `func`.
+
+   @return #PUGL_FAILURE if not supported on this platform or memory could
+   not be allocated, #PUGL_BAD_PARAMETER if the arguments are invalid.
+*/
+PUGL_API
+PuglStatus
+puglRegisterFd(PuglWorld*  world,
+               int         fd,
+               PuglFdFlags flags,
+               PuglFdFunc  func,
+               void*       data);
+
+/**
+   Stop watching a file descriptor.
+
+   This may be called from within the function of any registered descriptor,
+   including `fd` itself.  The descriptor is not closed.
+
+   @return #PUGL_FAILURE if `fd` is not registered or this is not supported.
+*/
+PUGL_API
+PuglStatus
+puglUnregisterFd(PuglWorld* world, int fd);
+
+/**
+   Start recording events to a trace file.
+
+   Until recording is stopped, every event dispatched to a view in this world
+   is written to the file at `path`, along with the time it was dispatched.
+   Create and destroy events are not recorded.  The trace can later be played
+   back with puglReplay(), for example to reproduce a session or measure
+   drawing performance with real input.
+
+   The trace is a compact binary format that is only meant to be read by the
+   same version of Pugl on the same platform.
+
+   @return #PUGL_FAILURE if the file could not be opened.
+*/
+PUGL_API
+PuglStatus
+puglStartRecording(PuglWorld* world, const char* path);
+
+/**
+   Stop recording events and close the trace file.
+
+   @return #PUGL_FAILURE if events are not being recorded.
+*/
+PUGL_API
+PuglStatus
+puglStopRecording(PuglWorld* world);
+
+/// Flags for replaying a trace
+typedef enum {
+  /// Dispatch events with the same timing as they were recorded
+  PUGL_REPLAY_REAL_TIME = 1u << 0u
+} PuglReplayFlag;
+
+/// Bitwise OR of #PuglReplayFlag values
+typedef uint32_t PuglReplayFlags;
+
+/**
+   Replay events from a trace file written by puglStartRecording().
+
+   Each event is dispatched to the view that was created in the same order as
+   the view it was recorded for, so this should be called with views set up
+   the same way as when the trace was recorded.  Events for views that don't
+   exist or aren't realized are skipped.
+
+   By default, events are dispatched as quickly as possible.  With
+   #PUGL_REPLAY_REAL_TIME, this function calls puglUpdate() while waiting
+   between events to reproduce the original timing, to within about a
+   millisecond.
+
+   @return #PUGL_FAILURE if the file could not be read, or
+   #PUGL_BAD_PARAMETER if it is not a valid trace.
+*/
+PUGL_API
+PuglStatus
+puglReplay(PuglWorld* world, const char* path, PuglReplayFlags flags);
+
+/**
+   Performance statistics for a world.
+
+   Times are in seconds and totals are accumulated since the world was
+   created.
+*/
+typedef struct {
+  uint64_t numUpdates;    ///< Number of calls to puglUpdate()
+  uint64_t numWakeUps;    ///< Number of times a wait for events woke up
+  uint64_t numFlushes;    ///< Number of flushes to the window system
+  uint64_t numTimerFires; ///< Number of timer events dispatched
+  uint64_t numEvents;     ///< Number of events dispatched to all views
+  double   eventTime;     ///< Time spent in event functions of all views
+} PuglWorldStats;
+
+/**
+   Get performance statistics for a world.
+
+   @return #PUGL_FAILURE if the world was not created with #PUGL_WORLD_STATS.
+*/
+PUGL_API
+PuglStatus
+puglGetWorldStats(const PuglWorld* world, PuglWorldStats* stats);
+
 /**
    @}
    @defgroup view View
@@ -796,7 +995,11 @@ typedef enum {
   PUGL_SWAP_INTERVAL,         ///< Number of frames between buffer swaps
   PUGL_RESIZABLE,             ///< True if view should be resizable
   PUGL_IGNORE_KEY_REPEAT,     ///< True if key repeat events are ignored
-  PUGL_REFRESH_RATE,          ///< Refresh rate in Hz
+  PUGL_REFRESH_RATE,          ///< Refresh rate in Hz of the current monitor
+  PUGL_COMPRESS_MOTION,       ///< True if motion events should be merged
+  PUGL_RETAIN_CONTENTS,       ///< True if drawn contents should be kept
+  PUGL_SHARE_CONTEXT,         ///< True if the context shares world objects
+  PUGL_STICKY_CONTEXT,        ///< True if the context may stay current
 
   PUGL_NUM_VIEW_HINTS
 } PuglViewHint;
@@ -811,6 +1014,17 @@ typedef enum {
 /// A function called when an event occurs
 typedef PuglStatus (*PuglEventFunc)(PuglView* view, const PuglEvent* event);
 
+/**
+   A function called with several events at once.
+
+   @param view The view the events were sent to.
+   @param events Array of events, in the order they occurred.
+   @param numEvents The number of events in `events`, at least 1.
+*/
+typedef PuglStatus (*PuglEventBatchFunc)(PuglView*        view,
+                                         const PuglEvent* events,
+                                         size_t           numEvents);
+
 /**
    @defgroup setup Setup
    Functions for creating and destroying a view.
@@ -882,6 +1096,32 @@ PUGL_API
 PuglStatus
 puglSetEventFunc(PuglView* view, PuglEventFunc eventFunc);
 
+/**
+   Set a function to receive events in batches.
+
+   When set, events that don't need a drawing context are collected during
+   each event loop iteration, and passed to this function as an array instead
+   of to the event function one at a time.  This is useful for views that
+   receive a lot of input, which can then be processed in a single loop.
+
+   The event function is still called for #PUGL_CREATE, #PUGL_DESTROY,
+   #PUGL_CONFIGURE, and #PUGL_EXPOSE events, since these are dispatched with
+   the drawing context entered.  Any pending batch is passed to this function
+   first, so events are always received in order for a view, but not
+   necessarily across different views.
+
+   Currently, events are only collected on X11.  On other platforms, and for
+   events dispatched outside of puglUpdate(), this function is called with a
+   single event at a time.
+
+   @param view The view to set the function for.
+   @param eventBatchFunc The function to call, or null to disable batching.
+   @return #PUGL_UNKNOWN_ERROR if memory for the batch could not be allocated.
+*/
+PUGL_API
+PuglStatus
+puglSetEventBatchFunc(PuglView* view, PuglEventBatchFunc eventBatchFunc);
+
 /**
    Set a hint to configure view properties.
 
@@ -1119,6 +1359,126 @@ PUGL_API
 PuglStatus
 puglPostRedisplayRect(PuglView* view, PuglRect rect);
 
+/**
+   Get the rectangles that need to be redrawn for the current expose.
+
+   The expose event always describes the bounding box of the damaged area,
+   which may be much larger than necessary if, for example, several small
+   distant rectangles were posted with puglPostRedisplayRect().  This can be
+   called while handling a #PUGL_EXPOSE event to get a more precise set of
+   rectangles, which do not overlap and are all within the expose region.  Where
+   the platform does not track damage precisely, this is a single rectangle
+   equal to the expose region.
+
+   @param view The view being exposed.
+   @param[out] count Set to the number of rectangles, or zero if the view is
+   not currently being exposed.
+   @return A pointer to an array of `count` rectangles, which is only valid
+   until the expose event handler returns.
+*/
+PUGL_API
+const PuglRect*
+puglGetExposeRects(const PuglView* view, size_t* count);
+
+/**
+   Performance statistics for a view.
+
+   Times are in seconds and totals are accumulated since the view was
+   created.  The time spent entering and leaving the graphics context depends
+   on the backend, for example, leaving may include swapping buffers.
+*/
+typedef struct {
+  /// Number of events dispatched, indexed by #PuglEventType
+  uint64_t numEvents[PUGL_LOOP_LEAVE + 1];
+
+  double   eventTime;  ///< Time spent in the event function
+  uint64_t numExposes; ///< Number of exposes dispatched
+  double   exposeArea; ///< Total area of exposes in pixels
+  uint64_t numEnters;  ///< Number of times the graphics context was entered
+  double   enterTime;  ///< Time spent entering the graphics context
+  double   leaveTime;  ///< Time spent leaving the graphics context
+} PuglViewStats;
+
+/**
+   Get performance statistics for a view.
+
+   @return #PUGL_FAILURE if the world was not created with #PUGL_WORLD_STATS.
+*/
+PUGL_API
+PuglStatus
+puglGetViewStats(const PuglView* view, PuglViewStats* stats);
+
+/// A phase of event handling or drawing that can be traced
+typedef enum {
+  PUGL_TRACE_UPDATE,    ///< A call to puglUpdate()
+  PUGL_TRACE_DISPATCH,  ///< Dispatching events from the window system
+  PUGL_TRACE_EXPOSURES, ///< Dispatching pending configures and exposes
+  PUGL_TRACE_ENTER,     ///< Entering the graphics context of a view
+  PUGL_TRACE_LEAVE,     ///< Leaving the graphics context of a view
+  PUGL_TRACE_EVENT      ///< Calling the event function of a view
+} PuglTracePhase;
+
+/**
+   A function called at the beginning and end of a traced phase.
+
+   @param world The world the phase happens in.
+   @param view The view for view phases, or null for world phases.
+   @param phase The phase that is beginning or ending.
+   @param type The type of event for #PUGL_TRACE_EVENT, otherwise (or for a
+   batch of several events) #PUGL_NOTHING.
+   @param begin True at the beginning of the phase, false at the end.
+   @param data The user data given to puglSetTraceFunc().
+*/
+typedef void (*PuglTraceFunc)(PuglWorld*     world,
+                              PuglView*      view,
+                              PuglTracePhase phase,
+                              PuglEventType  type,
+                              bool           begin,
+                              void*          data);
+
+/**
+   Set a function to call around phases of event handling and drawing.
+
+   This can be used to integrate Pugl with a profiler or tracing system, to see
+   how much time is spent where, and when.  Phases are properly nested, so
+   every beginning is followed by an end for the same phase.  The function is
+   called frequently, so it should be fast.
+
+   Currently, only view phases are traced on MacOS and Windows.
+
+   @param world The world to trace.
+   @param traceFunc The function to call, or null to stop tracing.
+   @param data User data to pass to `traceFunc`.
+*/
+PUGL_API
+PuglStatus
+puglSetTraceFunc(PuglWorld* world, PuglTraceFunc traceFunc, void* data);
+
+/**
+   Start writing a trace to a file in the Chrome trace event format.
+
+   This sets a built-in trace function which writes every phase to a JSON
+   file that can be loaded in Chrome's trace viewer or Perfetto.  Times are
+   from the system monotonic clock in microseconds, so they can be lined up
+   with traces from other threads that use the same clock.  Events have a
+   process and thread ID of 1, and the view index (in order of creation) as
+   an argument.
+
+   @return #PUGL_FAILURE if the file could not be opened.
+*/
+PUGL_API
+PuglStatus
+puglStartTraceFile(PuglWorld* world, const char* path);
+
+/**
+   Stop writing a trace and close the trace file.
+
+   @return #PUGL_FAILURE if a trace file is not being written.
+*/
+PUGL_API
+PuglStatus
+puglStopTraceFile(PuglWorld* world);
+
 /**
    @}
    @defgroup interaction Interaction
@@ -1226,7 +1586,8 @@ puglRequestAttention(PuglView* view);
    that should be a low number, typically the value of a constant or `enum`
    that starts from 0.  There is a platform-specific limit to the number of
    supported timers, and overhead associated with each, so applications should
-   create only a few timers and perform several tasks in one if necessary.
+   create only a few timers and perform several tasks in one if necessary.  On
+   X11, timers are managed by Pugl itself and are cheap, so this does not apply.
 
    @param timeout The period, in seconds, of this timer.  This is not
    guaranteed to have a resolution better than 10ms (the maximum timer
@@ -1273,6 +1634,47 @@ PUGL_API
 PuglStatus
 puglSendEvent(PuglView* view, const PuglEvent* event);
 
+/**
+   Post an event to a view from another thread.
+
+   Unlike most functions, this may be called from any thread, including
+   real-time threads.  It never blocks or calls into the window system, but
+   copies the event into a fixed-size queue which is drained by puglUpdate()
+   in the event loop thread, waking it up if necessary.
+
+   The world must have been created with #PUGL_WORLD_THREADS, and the view
+   must be realized.  Events for views that are freed before they are
+   delivered are dropped.
+
+   - X11: Any event type can be posted.  Posting an #PUGL_EXPOSE is the same
+     as calling puglPostRedisplayFromThread().
+   - Windows: Only #PUGL_CLIENT events are supported, which are posted with
+     puglSendEvent().
+   - MacOS: Not supported.
+
+   @return #PUGL_FAILURE if posting from threads is not supported or enabled,
+   the view is not realized, or the queue is full, #PUGL_UNSUPPORTED_TYPE if
+   the event type is not supported.
+*/
+PUGL_API
+PuglStatus
+puglPostEventFromThread(PuglView* view, const PuglEvent* event);
+
+/**
+   Request a redisplay of the given rectangle within the view from another
+   thread.
+
+   This is like puglPostRedisplayRect(), but may be called from any thread,
+   with the same constraints as puglPostEventFromThread().  It is intended
+   for things like updating meters from an audio thread.
+
+   @return #PUGL_FAILURE if posting from threads is not supported or enabled,
+   the view is not realized, or the queue is full.
+*/
+PUGL_API
+PuglStatus
+puglPostRedisplayFromThread(PuglView* view, PuglRect rect);
+
 /**
    @}
 */
@@ -19,10 +19,21 @@
 #include "pugl/pugl.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef MIN
+#  define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#  define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
 const char*
 puglStrerror(const PuglStatus status)
 {
@@ -89,6 +100,10 @@ puglSetDefaultHints(PuglHints hints)
   hints[PUGL_RESIZABLE]             = PUGL_FALSE;
   hints[PUGL_IGNORE_KEY_REPEAT]     = PUGL_FALSE;
   hints[PUGL_REFRESH_RATE]          = PUGL_DONT_CARE;
+  hints[PUGL_COMPRESS_MOTION]       = PUGL_FALSE;
+  hints[PUGL_RETAIN_CONTENTS]       = PUGL_FALSE;
+  hints[PUGL_SHARE_CONTEXT]         = PUGL_FALSE;
+  hints[PUGL_STICKY_CONTEXT]        = PUGL_FALSE;
 }
 
 PuglWorld*
@@ -100,7 +115,8 @@ puglNewWorld(PuglWorldType type, PuglWorldFlags flags)
     return NULL;
   }
 
-  world->startTime = puglGetTime(world);
+  world->startTime       = puglGetTime(world);
+  world->collectingStats = flags & PUGL_WORLD_STATS;
 
   puglSetString(&world->className, "Pugl");
 
@@ -110,6 +126,14 @@ puglNewWorld(PuglWorldType type, PuglWorldFlags flags)
 void
 puglFreeWorld(PuglWorld* const world)
 {
+  if (world->recording) {
+    puglStopRecording(world);
+  }
+
+  if (world->traceFile) {
+    puglStopTraceFile(world);
+  }
+
   puglFreeWorldInternals(world);
   free(world->className);
   free(world->views);
@@ -183,6 +207,7 @@ puglFreeView(PuglView* view)
 
   free(view->title);
   free(view->clipboard.data);
+  free(view->batch);
   puglFreeViewInternals(view);
   free(view);
 }
@@ -271,6 +296,205 @@ puglGetContext(PuglView* view)
   return view->backend->getContext(view);
 }
 
+const PuglRect*
+puglGetExposeRects(const PuglView* view, size_t* count)
+{
+  *count = view->damage.numRects;
+  return view->damage.rects;
+}
+
+PuglStatus
+puglGetWorldStats(const PuglWorld* world, PuglWorldStats* stats)
+{
+  if (!world->collectingStats) {
+    return PUGL_FAILURE;
+  }
+
+  *stats = world->stats;
+  return PUGL_SUCCESS;
+}
+
+PuglStatus
+puglGetViewStats(const PuglView* view, PuglViewStats* stats)
+{
+  if (!view->world->collectingStats) {
+    return PUGL_FAILURE;
+  }
+
+  *stats = view->stats;
+  return PUGL_SUCCESS;
+}
+
+PuglStatus
+puglSetTraceFunc(PuglWorld* world, PuglTraceFunc traceFunc, void* data)
+{
+  world->traceFunc = traceFunc;
+  world->traceData = data;
+  return PUGL_SUCCESS;
+}
+
+void
+puglTrace(PuglWorld* const     world,
+          PuglView* const      view,
+          const PuglTracePhase phase,
+          const PuglEventType  type,
+          const bool           begin)
+{
+  if (world->traceFunc) {
+    world->traceFunc(world, view, phase, type, begin, world->traceData);
+  }
+}
+
+static const char*
+puglEventTypeName(const PuglEventType type)
+{
+  switch (type) {
+  case PUGL_NOTHING:
+    return "events";
+  case PUGL_CREATE:
+    return "create";
+  case PUGL_DESTROY:
+    return "destroy";
+  case PUGL_CONFIGURE:
+    return "configure";
+  case PUGL_MAP:
+    return "map";
+  case PUGL_UNMAP:
+    return "unmap";
+  case PUGL_UPDATE:
+    return "update";
+  case PUGL_EXPOSE:
+    return "expose";
+  case PUGL_CLOSE:
+    return "close";
+  case PUGL_FOCUS_IN:
+    return "focus in";
+  case PUGL_FOCUS_OUT:
+    return "focus out";
+  case PUGL_KEY_PRESS:
+    return "key press";
+  case PUGL_KEY_RELEASE:
+    return "key release";
+  case PUGL_TEXT:
+    return "text";
+  case PUGL_POINTER_IN:
+    return "pointer in";
+  case PUGL_POINTER_OUT:
+    return "pointer out";
+  case PUGL_BUTTON_PRESS:
+    return "button press";
+  case PUGL_BUTTON_RELEASE:
+    return "button release";
+  case PUGL_MOTION:
+    return "motion";
+  case PUGL_SCROLL:
+    return "scroll";
+  case PUGL_CLIENT:
+    return "client";
+  case PUGL_TIMER:
+    return "timer";
+  case PUGL_LOOP_ENTER:
+    return "loop enter";
+  case PUGL_LOOP_LEAVE:
+    return "loop leave";
+  }
+
+  return "unknown";
+}
+
+static const char*
+puglTracePhaseName(const PuglTracePhase phase, const PuglEventType type)
+{
+  switch (phase) {
+  case PUGL_TRACE_UPDATE:
+    return "update loop";
+  case PUGL_TRACE_DISPATCH:
+    return "dispatch";
+  case PUGL_TRACE_EXPOSURES:
+    return "exposures";
+  case PUGL_TRACE_ENTER:
+    return "enter context";
+  case PUGL_TRACE_LEAVE:
+    return "leave context";
+  case PUGL_TRACE_EVENT:
+    break;
+  }
+
+  return puglEventTypeName(type);
+}
+
+static void
+puglWriteTraceEvent(PuglWorld* const     world,
+                    PuglView* const      view,
+                    const PuglTracePhase phase,
+                    const PuglEventType  type,
+                    const bool           begin,
+                    void* const          data)
+{
+  FILE* const    file = (FILE*)data;
+  const double   now  = puglGetTime(world) + world->startTime;
+  const uint64_t ns   = (uint64_t)(now * 1000000000.0);
+
+  // Print the timestamp with integers to avoid locale-specific formatting
+  fprintf(file,
+          ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+          "\"ts\":%" PRIu64 ".%03u,\"pid\":1,\"tid\":1",
+          puglTracePhaseName(phase, type),
+          view ? "view" : "world",
+          begin ? 'B' : 'E',
+          ns / 1000u,
+          (unsigned)(ns % 1000u));
+
+  if (view) {
+    size_t index = 0u;
+    while (index < world->numViews && world->views[index] != view) {
+      ++index;
+    }
+
+    fprintf(file, ",\"args\":{\"view\":%u}", (unsigned)index);
+  }
+
+  fputc('}', file);
+}
+
+PuglStatus
+puglStartTraceFile(PuglWorld* const world, const char* const path)
+{
+  if (world->traceFile) {
+    puglStopTraceFile(world);
+  }
+
+  if (!(world->traceFile = fopen(path, "w"))) {
+    return PUGL_FAILURE;
+  }
+
+  // Name the thread, which also starts the array so events can be appended
+  fputs("[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+        "\"args\":{\"name\":\"Pugl\"}}",
+        world->traceFile);
+
+  return puglSetTraceFunc(world, puglWriteTraceEvent, world->traceFile);
+}
+
+PuglStatus
+puglStopTraceFile(PuglWorld* const world)
+{
+  if (!world->traceFile) {
+    return PUGL_FAILURE;
+  }
+
+  if (world->traceFunc == puglWriteTraceEvent) {
+    puglSetTraceFunc(world, NULL, NULL);
+  }
+
+  fputs("\n]\n", world->traceFile);
+
+  const int st = fclose(world->traceFile);
+
+  world->traceFile = NULL;
+  return st ? PUGL_FAILURE : PUGL_SUCCESS;
+}
+
 #ifndef PUGL_DISABLE_DEPRECATED
 
 PuglStatus
@@ -306,6 +530,241 @@ puglSetEventFunc(PuglView* view, PuglEventFunc eventFunc)
   return PUGL_SUCCESS;
 }
 
+PuglStatus
+puglSetEventBatchFunc(PuglView* view, PuglEventBatchFunc eventBatchFunc)
+{
+  puglFlushEventBatch(view);
+
+  if (eventBatchFunc && !view->batch &&
+      !(view->batch =
+          (PuglEvent*)calloc(PUGL_MAX_BATCH_EVENTS, sizeof(PuglEvent)))) {
+    return PUGL_UNKNOWN_ERROR;
+  }
+
+  view->eventBatchFunc = eventBatchFunc;
+  return PUGL_SUCCESS;
+}
+
+size_t
+puglEventSize(const PuglEventType type)
+{
+  switch (type) {
+  case PUGL_CONFIGURE:
+    return sizeof(PuglEventConfigure);
+  case PUGL_EXPOSE:
+    return sizeof(PuglEventExpose);
+  case PUGL_FOCUS_IN:
+  case PUGL_FOCUS_OUT:
+    return sizeof(PuglEventFocus);
+  case PUGL_KEY_PRESS:
+  case PUGL_KEY_RELEASE:
+    return sizeof(PuglEventKey);
+  case PUGL_TEXT:
+    return sizeof(PuglEventText);
+  case PUGL_POINTER_IN:
+  case PUGL_POINTER_OUT:
+    return sizeof(PuglEventCrossing);
+  case PUGL_BUTTON_PRESS:
+  case PUGL_BUTTON_RELEASE:
+    return sizeof(PuglEventButton);
+  case PUGL_MOTION:
+    return sizeof(PuglEventMotion);
+  case PUGL_SCROLL:
+    return sizeof(PuglEventScroll);
+  case PUGL_CLIENT:
+    return sizeof(PuglEventClient);
+  case PUGL_TIMER:
+    return sizeof(PuglEventTimer);
+  default:
+    break;
+  }
+
+  return sizeof(PuglEventAny);
+}
+
+/// Header at the start of a recording
+typedef struct {
+  char     magic[8];  ///< "PuglTrc" with a null terminator
+  uint32_t version;   ///< Trace format version, currently 1
+  uint32_t eventSize; ///< Size of PuglEvent, to detect incompatible traces
+} PuglRecordingHeader;
+
+/// Header before each event in a recording, followed by `size` bytes
+typedef struct {
+  double   time; ///< Time since recording started in seconds
+  uint32_t view; ///< Index of view in world, in order of creation
+  uint32_t size; ///< Size of the event that follows in bytes
+} PuglRecordingEntry;
+
+/// How early an event may be dispatched when replaying in real time
+static const double puglReplayTolerance = 0.001;
+
+static const PuglRecordingHeader puglRecordingHeader = {
+  "PuglTrc",
+  1u,
+  (uint32_t)sizeof(PuglEvent)};
+
+PuglStatus
+puglStartRecording(PuglWorld* const world, const char* const path)
+{
+  if (world->recording) {
+    puglStopRecording(world);
+  }
+
+  if (!(world->recording = fopen(path, "wb"))) {
+    return PUGL_FAILURE;
+  }
+
+  const PuglRecordingHeader* const header = &puglRecordingHeader;
+  if (fwrite(header, sizeof(*header), 1, world->recording) != 1) {
+    fclose(world->recording);
+    world->recording = NULL;
+    return PUGL_FAILURE;
+  }
+
+  world->recordingStartTime = puglGetTime(world);
+  return PUGL_SUCCESS;
+}
+
+PuglStatus
+puglStopRecording(PuglWorld* const world)
+{
+  if (!world->recording) {
+    return PUGL_FAILURE;
+  }
+
+  const int st = fclose(world->recording);
+
+  world->recording = NULL;
+  return st ? PUGL_FAILURE : PUGL_SUCCESS;
+}
+
+static void
+puglRecordEvent(const PuglView* const view, const PuglEvent* const event)
+{
+  PuglWorld* const world = view->world;
+
+  size_t index = 0u;
+  while (index < world->numViews && world->views[index] != view) {
+    ++index;
+  }
+
+  const double             now    = puglGetTime(world);
+  const PuglRecordingEntry record = {now - world->recordingStartTime,
+                                     (uint32_t)index,
+                                     (uint32_t)puglEventSize(event->type)};
+
+  if (fwrite(&record, sizeof(record), 1, world->recording) != 1 ||
+      fwrite(event, record.size, 1, world->recording) != 1) {
+    // Stop rather than write a truncated recording on every event
+    puglStopRecording(world);
+  }
+}
+
+PuglStatus
+puglReplay(PuglWorld* const      world,
+           const char* const     path,
+           const PuglReplayFlags flags)
+{
+  FILE* const file = fopen(path, "rb");
+  if (!file) {
+    return PUGL_FAILURE;
+  }
+
+  PuglRecordingHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(&header, &puglRecordingHeader, sizeof(header))) {
+    fclose(file);
+    return PUGL_BAD_PARAMETER;
+  }
+
+  const double       startTime = puglGetTime(world);
+  PuglStatus         st        = PUGL_SUCCESS;
+  PuglRecordingEntry record;
+  PuglEvent          event;
+  while (!st && fread(&record, sizeof(record), 1, file) == 1) {
+    memset(&event, 0, sizeof(event));
+    if (record.size > sizeof(event) ||
+        fread(&event, record.size, 1, file) != 1) {
+      st = PUGL_BAD_PARAMETER;
+      break;
+    }
+
+    if (flags & PUGL_REPLAY_REAL_TIME) {
+      // Keep the event loop running until the event is nearly due, since
+      // updates with shorter timeouts don't block and would only spin
+      double now = puglGetTime(world) - startTime;
+      while (now < record.time - puglReplayTolerance) {
+        puglUpdate(world, record.time - now);
+        now = puglGetTime(world) - startTime;
+      }
+    }
+
+    if (record.view < world->numViews) {
+      PuglView* const view = world->views[record.view];
+      if (puglIsRealized(view)) {
+        puglDispatchEvent(view, &event);
+      }
+    }
+  }
+
+  fclose(file);
+  return st;
+}
+
+static bool
+puglRectsTouch(const PuglRect a, const PuglRect b)
+{
+  return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+         a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+static PuglRect
+puglRectUnion(const PuglRect a, const PuglRect b)
+{
+  const double x = MIN(a.x, b.x);
+  const double y = MIN(a.y, b.y);
+
+  const PuglRect rect = {x,
+                         y,
+                         MAX(a.x + a.width, b.x + b.width) - x,
+                         MAX(a.y + a.height, b.y + b.height) - y};
+
+  return rect;
+}
+
+void
+puglRegionAdd(PuglRegion* const region, PuglRect rect)
+{
+  if (rect.width <= 0.0 || rect.height <= 0.0) {
+    return;
+  }
+
+  // Merge with any touching rectangles, so the region never overlaps itself
+  for (size_t i = 0; i < region->numRects;) {
+    if (puglRectsTouch(region->rects[i], rect)) {
+      // Replace with the last rectangle and start over with the union
+      rect             = puglRectUnion(region->rects[i], rect);
+      region->rects[i] = region->rects[--region->numRects];
+      i                = 0;
+    } else {
+      ++i;
+    }
+  }
+
+  if (region->numRects < PUGL_MAX_REGION_RECTS) {
+    region->rects[region->numRects++] = rect;
+  } else {
+    // Too many rectangles, fall back to the bounding box
+    for (size_t i = 0; i < region->numRects; ++i) {
+      rect = puglRectUnion(rect, region->rects[i]);
+    }
+
+    region->rects[0] = rect;
+    region->numRects = 1;
+  }
+}
+
 /// Return the code point for buf, or the replacement character on error
 uint32_t
 puglDecodeUTF8(const uint8_t* buf)
@@ -372,6 +831,97 @@ puglDispatchSimpleEvent(PuglView* view, const PuglEventType type)
   puglDispatchEvent(view, &event);
 }
 
+void
+puglEnterBackend(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglWorld* const world = view->world;
+  const double     t     = world->collectingStats ? puglGetTime(world) : 0.0;
+
+  puglTrace(world, view, PUGL_TRACE_ENTER, PUGL_NOTHING, true);
+  view->backend->enter(view, expose);
+  puglTrace(world, view, PUGL_TRACE_ENTER, PUGL_NOTHING, false);
+
+  if (world->collectingStats) {
+    view->stats.enterTime += puglGetTime(world) - t;
+    ++view->stats.numEnters;
+  }
+}
+
+void
+puglLeaveBackend(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglWorld* const world = view->world;
+  const double     t     = world->collectingStats ? puglGetTime(world) : 0.0;
+
+  puglTrace(world, view, PUGL_TRACE_LEAVE, PUGL_NOTHING, true);
+  view->backend->leave(view, expose);
+  puglTrace(world, view, PUGL_TRACE_LEAVE, PUGL_NOTHING, false);
+
+  if (world->collectingStats) {
+    view->stats.leaveTime += puglGetTime(world) - t;
+  }
+}
+
+static void
+puglCountEvent(PuglView* view, const PuglEvent* event)
+{
+  ++view->world->stats.numEvents;
+  ++view->stats.numEvents[event->type];
+
+  if (event->type == PUGL_EXPOSE) {
+    ++view->stats.numExposes;
+    view->stats.exposeArea += event->expose.width * event->expose.height;
+  }
+}
+
+static void
+puglAddEventTime(PuglView* view, const double seconds)
+{
+  view->stats.eventTime += seconds;
+  view->world->stats.eventTime += seconds;
+}
+
+/// Call the event function, recording and tracing the event if necessary
+static void
+puglCallEventFunc(PuglView* view, const PuglEvent* event)
+{
+  PuglWorld* const world = view->world;
+  const double     t     = world->collectingStats ? puglGetTime(world) : 0.0;
+
+  if (world->recording && event->type != PUGL_CREATE &&
+      event->type != PUGL_DESTROY) {
+    puglRecordEvent(view, event);
+  }
+
+  puglTrace(world, view, PUGL_TRACE_EVENT, event->type, true);
+  view->eventFunc(view, event);
+  puglTrace(world, view, PUGL_TRACE_EVENT, event->type, false);
+
+  if (world->collectingStats) {
+    puglCountEvent(view, event);
+    puglAddEventTime(view, puglGetTime(world) - t);
+  }
+}
+
+/// Call the batch function, tracing it if necessary
+static void
+puglCallEventBatchFunc(PuglView*        view,
+                       const PuglEvent* events,
+                       const size_t     numEvents)
+{
+  PuglWorld* const    world = view->world;
+  const double        t     = world->collectingStats ? puglGetTime(world) : 0.0;
+  const PuglEventType type  = numEvents == 1u ? events[0].type : PUGL_NOTHING;
+
+  puglTrace(world, view, PUGL_TRACE_EVENT, type, true);
+  view->eventBatchFunc(view, events, numEvents);
+  puglTrace(world, view, PUGL_TRACE_EVENT, type, false);
+
+  if (world->collectingStats) {
+    puglAddEventTime(view, puglGetTime(world) - t);
+  }
+}
+
 void
 puglDispatchEventInContext(PuglView* view, const PuglEvent* event)
 {
@@ -382,16 +932,76 @@ puglDispatchEventInContext(PuglView* view, const PuglEvent* event)
     view->frame.height = event->configure.height;
 
     if (puglMustConfigure(view, &event->configure)) {
-      view->eventFunc(view, event);
+      puglCallEventFunc(view, event);
       view->lastConfigure = event->configure;
     }
   } else if (event->type == PUGL_EXPOSE) {
     if (event->expose.width > 0 && event->expose.height > 0) {
-      view->eventFunc(view, event);
+      // Use the exposed area if the platform has not set a damaged region
+      const bool ownsDamage = !view->damage.numRects;
+      if (ownsDamage) {
+        const PuglRect rect = {event->expose.x,
+                               event->expose.y,
+                               event->expose.width,
+                               event->expose.height};
+
+        puglRegionAdd(&view->damage, rect);
+      }
+
+      puglCallEventFunc(view, event);
+
+      if (ownsDamage) {
+        view->damage.numRects = 0;
+      }
     }
   } else {
-    view->eventFunc(view, event);
+    puglCallEventFunc(view, event);
+  }
+}
+
+void
+puglFlushEventBatch(PuglView* view)
+{
+  const size_t numBatched = view->numBatched;
+
+  if (numBatched) {
+    view->numBatched = 0u;
+    puglCallEventBatchFunc(view, view->batch, numBatched);
+  }
+}
+
+void
+puglBeginEventBatches(PuglWorld* world)
+{
+  world->batchingEvents = true;
+}
+
+void
+puglFlushEventBatches(PuglWorld* world)
+{
+  for (size_t i = 0u; i < world->numViews; ++i) {
+    puglFlushEventBatch(world->views[i]);
+  }
+
+  world->batchingEvents = false;
+}
+
+static void
+puglBatchEvent(PuglView* view, const PuglEvent* event)
+{
+  if (!view->world->batchingEvents) {
+    puglCallEventBatchFunc(view, event, 1u);
+    return;
+  }
+
+  if (view->numBatched == PUGL_MAX_BATCH_EVENTS) {
+    puglFlushEventBatch(view);
   }
+
+  // The event may be a smaller struct, so copy only what is there
+  PuglEvent* const slot = &view->batch[view->numBatched++];
+  memset(slot, 0, sizeof(PuglEvent));
+  memcpy(slot, event, puglEventSize(event->type));
 }
 
 void
@@ -402,24 +1012,40 @@ puglDispatchEvent(PuglView* view, const PuglEvent* event)
     break;
   case PUGL_CREATE:
   case PUGL_DESTROY:
-    view->backend->enter(view, NULL);
-    view->eventFunc(view, event);
-    view->backend->leave(view, NULL);
+    puglFlushEventBatch(view);
+    puglEnterBackend(view, NULL);
+    puglCallEventFunc(view, event);
+    puglLeaveBackend(view, NULL);
     break;
   case PUGL_CONFIGURE:
     if (puglMustConfigure(view, &event->configure)) {
-      view->backend->enter(view, NULL);
+      puglFlushEventBatch(view);
+      puglEnterBackend(view, NULL);
       puglDispatchEventInContext(view, event);
-      view->backend->leave(view, NULL);
+      puglLeaveBackend(view, NULL);
     }
     break;
   case PUGL_EXPOSE:
-    view->backend->enter(view, &event->expose);
+    puglFlushEventBatch(view);
+    puglEnterBackend(view, &event->expose);
     puglDispatchEventInContext(view, event);
-    view->backend->leave(view, &event->expose);
+    puglLeaveBackend(view, &event->expose);
     break;
   default:
-    view->eventFunc(view, event);
+    if (!view->eventBatchFunc) {
+      puglCallEventFunc(view, event);
+      break;
+    }
+
+    if (view->world->recording) {
+      puglRecordEvent(view, event);
+    }
+
+    if (view->world->collectingStats) {
+      puglCountEvent(view, event);
+    }
+
+    puglBatchEvent(view, event);
   }
 }
 
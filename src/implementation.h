@@ -50,10 +50,38 @@ puglInitViewInternals(void);
 void
 puglFreeViewInternals(PuglView* view);
 
+/// Return true if `view` has been realized (implemented once per platform)
+bool
+puglIsRealized(const PuglView* view);
+
+/// Return the size of the event structure used for events of `type`
+size_t
+puglEventSize(PuglEventType type);
+
+/// Add `rect` to `region`, merging it with any rectangles it touches
+void
+puglRegionAdd(PuglRegion* region, PuglRect rect);
+
 /// Return the Unicode code point for `buf` or the replacement character
 uint32_t
 puglDecodeUTF8(const uint8_t* buf);
 
+/// Call the trace function at the beginning or end of a phase, if it is set
+void
+puglTrace(PuglWorld*     world,
+          PuglView*      view,
+          PuglTracePhase phase,
+          PuglEventType  type,
+          bool           begin);
+
+/// Enter the graphics context of `view`, for drawing if expose is non-null
+void
+puglEnterBackend(PuglView* view, const PuglEventExpose* expose);
+
+/// Leave the graphics context of `view`, after drawing if expose is non-null
+void
+puglLeaveBackend(PuglView* view, const PuglEventExpose* expose);
+
 /// Dispatch an event with a simple `type` to `view`
 void
 puglDispatchSimpleEvent(PuglView* view, PuglEventType type);
@@ -66,6 +94,18 @@ puglDispatchEventInContext(PuglView* view, const PuglEvent* event);
 void
 puglDispatchEvent(PuglView* view, const PuglEvent* event);
 
+/// Pass any events collected for `view` to its batch function
+void
+puglFlushEventBatch(PuglView* view);
+
+/// Start collecting events for views with a batch function
+void
+puglBeginEventBatches(PuglWorld* world);
+
+/// Pass all collected events to batch functions and stop collecting
+void
+puglFlushEventBatches(PuglWorld* world);
+
 /// Set internal (stored in view) clipboard contents
 const void*
 puglGetInternalClipboard(const PuglView* view, const char** type, size_t* len);
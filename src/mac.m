@@ -404,6 +404,8 @@ handleCrossing(PuglWrapperView* view, NSEvent* event, const PuglEventType type)
     rloc.x,
     [[NSScreen mainScreen] frame].size.height - rloc.y,
     getModifiers(event),
+    [event timestamp],
+    1u,
   };
 
   puglDispatchEvent(puglview, (const PuglEvent*)&ev);
@@ -817,8 +819,12 @@ handleCrossing(PuglWrapperView* view, NSEvent* event, const PuglEventType type)
 @end
 
 PuglWorldInternals*
-puglInitWorldInternals(PuglWorldType type, PuglWorldFlags PUGL_UNUSED(flags))
+puglInitWorldInternals(PuglWorldType type, PuglWorldFlags flags)
 {
+  if (flags & PUGL_WORLD_HEADLESS) {
+    return NULL; // Not supported
+  }
+
   PuglWorldInternals* impl =
     (PuglWorldInternals*)calloc(1, sizeof(PuglWorldInternals));
 
@@ -1046,6 +1052,12 @@ puglHide(PuglView* view)
   return PUGL_SUCCESS;
 }
 
+bool
+puglIsRealized(const PuglView* view)
+{
+  return view->impl->wrapperView != nil;
+}
+
 void
 puglFreeViewInternals(PuglView* view)
 {
@@ -1160,6 +1172,20 @@ puglSendEvent(PuglView* view, const PuglEvent* event)
   return PUGL_UNSUPPORTED_TYPE;
 }
 
+PuglStatus
+puglPostEventFromThread(PuglView* PUGL_UNUSED(view),
+                        const PuglEvent* PUGL_UNUSED(event))
+{
+  return PUGL_FAILURE;
+}
+
+PuglStatus
+puglPostRedisplayFromThread(PuglView* PUGL_UNUSED(view),
+                            const PuglRect PUGL_UNUSED(rect))
+{
+  return PUGL_FAILURE;
+}
+
 #ifndef PUGL_DISABLE_DEPRECATED
 PuglStatus
 puglWaitForEvent(PuglView* view)
@@ -1188,6 +1214,10 @@ dispatchClientEvent(PuglWorld* world, NSEvent* ev)
 PuglStatus
 puglUpdate(PuglWorld* world, const double timeout)
 {
+  if (world->collectingStats) {
+    ++world->stats.numUpdates;
+  }
+
   NSDate* date =
     ((timeout < 0) ? [NSDate distantFuture]
                    : [NSDate dateWithTimeIntervalSinceNow:timeout]);
@@ -1223,6 +1253,22 @@ puglUpdate(PuglWorld* world, const double timeout)
   return PUGL_SUCCESS;
 }
 
+PuglStatus
+puglRegisterFd(PuglWorld*  PUGL_UNUSED(world),
+               int         PUGL_UNUSED(fd),
+               PuglFdFlags PUGL_UNUSED(flags),
+               PuglFdFunc  PUGL_UNUSED(func),
+               void*       PUGL_UNUSED(data))
+{
+  return PUGL_FAILURE;
+}
+
+PuglStatus
+puglUnregisterFd(PuglWorld* PUGL_UNUSED(world), int PUGL_UNUSED(fd))
+{
+  return PUGL_FAILURE;
+}
+
 #ifndef PUGL_DISABLE_DEPRECATED
 PuglStatus
 puglProcessEvents(PuglView* view)
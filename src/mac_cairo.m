@@ -158,3 +158,20 @@ puglCairoBackend(void)
 
   return &backend;
 }
+
+const PuglBackend*
+puglCairoShmBackend(void)
+{
+  return puglCairoBackend();
+}
+
+PuglStatus
+puglSetCairoTileFunc(PuglView* const         view,
+                     const PuglCairoTileFunc tileFunc,
+                     const unsigned          numThreads)
+{
+  (void)view;
+  (void)tileFunc;
+  (void)numThreads;
+  return PUGL_FAILURE;
+}
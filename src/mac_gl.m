@@ -60,6 +60,10 @@
     puglview->hints[PUGL_SWAP_INTERVAL] = 1;
   }
 
+  // Sharing and sticky contexts are not yet supported on MacOS
+  puglview->hints[PUGL_SHARE_CONTEXT]  = PUGL_FALSE;
+  puglview->hints[PUGL_STICKY_CONTEXT] = PUGL_FALSE;
+
   const unsigned colorSize = (unsigned)(puglview->hints[PUGL_RED_BITS] +
                                         puglview->hints[PUGL_BLUE_BITS] +
                                         puglview->hints[PUGL_GREEN_BITS] +
@@ -196,6 +200,34 @@ puglLeaveContext(PuglView* view)
   return view->backend->leave(view, NULL);
 }
 
+PuglStatus
+puglReadPixels(PuglView* PUGL_UNUSED(view),
+               void*     PUGL_UNUSED(pixels),
+               size_t    PUGL_UNUSED(stride))
+{
+  return PUGL_UNSUPPORTED_TYPE;
+}
+
+PuglStatus
+puglStartCapture(PuglView*         PUGL_UNUSED(view),
+                 PuglGlCaptureFunc PUGL_UNUSED(func))
+{
+  return PUGL_UNSUPPORTED_TYPE;
+}
+
+PuglStatus
+puglStopCapture(PuglView* PUGL_UNUSED(view))
+{
+  return PUGL_FAILURE;
+}
+
+PuglStatus
+puglGetFrameStats(const PuglView*   PUGL_UNUSED(view),
+                  PuglGlFrameStats* PUGL_UNUSED(stats))
+{
+  return PUGL_UNSUPPORTED_TYPE;
+}
+
 const PuglBackend*
 puglGlBackend(void)
 {
@@ -208,3 +240,9 @@ puglGlBackend(void)
 
   return &backend;
 }
+
+const PuglBackend*
+puglEglBackend(void)
+{
+  return NULL;
+}
@@ -22,6 +22,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 // Unused parameter macro to suppresses warnings and make it impossible to use
 #if defined(__cplusplus)
@@ -47,6 +48,18 @@ typedef struct {
   size_t len;  ///< Length of data in bytes
 } PuglBlob;
 
+/// Maximum number of rectangles in a region before it is simplified
+#define PUGL_MAX_REGION_RECTS 8u
+
+/// Maximum number of events collected for a batch before it is delivered
+#define PUGL_MAX_BATCH_EVENTS 64u
+
+/// Area made of several rectangles, for tracking damage
+typedef struct {
+  PuglRect rects[PUGL_MAX_REGION_RECTS]; ///< Non-overlapping rectangles
+  size_t   numRects;                     ///< Number of rectangles
+} PuglRegion;
+
 /// Cross-platform view definition
 struct PuglViewImpl {
   PuglWorld*         world;
@@ -54,12 +67,17 @@ struct PuglViewImpl {
   PuglInternals*     impl;
   PuglHandle         handle;
   PuglEventFunc      eventFunc;
+  PuglEventBatchFunc eventBatchFunc;
+  PuglEvent*         batch;
+  size_t             numBatched;
   char*              title;
   PuglBlob           clipboard;
   PuglNativeView     parent;
   uintptr_t          transientParent;
   PuglRect           frame;
   PuglEventConfigure lastConfigure;
+  PuglRegion         damage;
+  PuglViewStats      stats;
   PuglHints          hints;
   int                defaultWidth;
   int                defaultHeight;
@@ -82,6 +100,14 @@ struct PuglWorldImpl {
   double              startTime;
   size_t              numViews;
   PuglView**          views;
+  FILE*               recording;
+  double              recordingStartTime;
+  PuglTraceFunc       traceFunc;
+  void*               traceData;
+  FILE*               traceFile;
+  PuglWorldStats      stats;
+  bool                collectingStats;
+  bool                batchingEvents;
 };
 
 /// Opaque surface used by graphics backend
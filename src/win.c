@@ -102,9 +102,12 @@ puglRegisterWindowClass(const char* name)
 }
 
 PuglWorldInternals*
-puglInitWorldInternals(PuglWorldType  PUGL_UNUSED(type),
-                       PuglWorldFlags PUGL_UNUSED(flags))
+puglInitWorldInternals(PuglWorldType PUGL_UNUSED(type), PuglWorldFlags flags)
 {
+  if (flags & PUGL_WORLD_HEADLESS) {
+    return NULL; // Not supported
+  }
+
   PuglWorldInternals* impl =
     (PuglWorldInternals*)calloc(1, sizeof(PuglWorldInternals));
   if (!impl) {
@@ -237,6 +240,12 @@ puglHide(PuglView* view)
   return PUGL_SUCCESS;
 }
 
+bool
+puglIsRealized(const PuglView* view)
+{
+  return view->impl->hwnd != NULL;
+}
+
 void
 puglFreeViewInternals(PuglView* view)
 {
@@ -643,13 +652,15 @@ handleMessage(PuglView* view, UINT message, WPARAM wParam, LPARAM lParam)
     }
 
     ClientToScreen(view->impl->hwnd, &pt);
-    event.motion.type  = PUGL_MOTION;
-    event.motion.time  = GetMessageTime() / 1e3;
-    event.motion.x     = GET_X_LPARAM(lParam);
-    event.motion.y     = GET_Y_LPARAM(lParam);
-    event.motion.xRoot = pt.x;
-    event.motion.yRoot = pt.y;
-    event.motion.state = getModifiers();
+    event.motion.type      = PUGL_MOTION;
+    event.motion.time      = GetMessageTime() / 1e3;
+    event.motion.x         = GET_X_LPARAM(lParam);
+    event.motion.y         = GET_Y_LPARAM(lParam);
+    event.motion.xRoot     = pt.x;
+    event.motion.yRoot     = pt.y;
+    event.motion.state     = getModifiers();
+    event.motion.firstTime = event.motion.time;
+    event.motion.count     = 1u;
     break;
   case WM_MOUSELEAVE:
     GetCursorPos(&pt);
@@ -787,6 +798,20 @@ puglSendEvent(PuglView* view, const PuglEvent* event)
   return PUGL_UNSUPPORTED_TYPE;
 }
 
+PuglStatus
+puglPostEventFromThread(PuglView* view, const PuglEvent* event)
+{
+  // PostMessage() is thread-safe and does not block
+  return puglSendEvent(view, event);
+}
+
+PuglStatus
+puglPostRedisplayFromThread(PuglView* view, const PuglRect rect)
+{
+  // InvalidateRect() is thread-safe and does not block
+  return puglPostRedisplayRect(view, rect);
+}
+
 #ifndef PUGL_DISABLE_DEPRECATED
 PuglStatus
 puglWaitForEvent(PuglView* PUGL_UNUSED(view))
@@ -843,6 +868,10 @@ puglUpdate(PuglWorld* world, double timeout)
   const double startTime = puglGetTime(world);
   PuglStatus   st        = PUGL_SUCCESS;
 
+  if (world->collectingStats) {
+    ++world->stats.numUpdates;
+  }
+
   if (timeout < 0.0) {
     st = puglPollWinEvents(world, timeout);
     st = st ? st : puglDispatchWinEvents(world);
@@ -869,6 +898,22 @@ puglUpdate(PuglWorld* world, double timeout)
   return st;
 }
 
+PuglStatus
+puglRegisterFd(PuglWorld*  PUGL_UNUSED(world),
+               int         PUGL_UNUSED(fd),
+               PuglFdFlags PUGL_UNUSED(flags),
+               PuglFdFunc  PUGL_UNUSED(func),
+               void*       PUGL_UNUSED(data))
+{
+  return PUGL_FAILURE;
+}
+
+PuglStatus
+puglUnregisterFd(PuglWorld* PUGL_UNUSED(world), int PUGL_UNUSED(fd))
+{
+  return PUGL_FAILURE;
+}
+
 #ifndef PUGL_DISABLE_DEPRECATED
 PuglStatus
 puglProcessEvents(PuglView* view)
@@ -176,3 +176,20 @@ puglCairoBackend()
 
   return &backend;
 }
+
+const PuglBackend*
+puglCairoShmBackend()
+{
+  return puglCairoBackend();
+}
+
+PuglStatus
+puglSetCairoTileFunc(PuglView* const         view,
+                     const PuglCairoTileFunc tileFunc,
+                     const unsigned          numThreads)
+{
+  (void)view;
+  (void)tileFunc;
+  (void)numThreads;
+  return PUGL_FAILURE;
+}
@@ -119,6 +119,10 @@ puglWinGlConfigure(PuglView* view)
     view->hints[PUGL_SWAP_INTERVAL] = 1;
   }
 
+  // Sharing and sticky contexts are not yet supported on Windows
+  view->hints[PUGL_SHARE_CONTEXT]  = PUGL_FALSE;
+  view->hints[PUGL_STICKY_CONTEXT] = PUGL_FALSE;
+
   // clang-format off
   const int pixelAttrs[] = {
     WGL_DRAW_TO_WINDOW_ARB, GL_TRUE,
@@ -313,6 +317,34 @@ puglLeaveContext(PuglView* view)
   return view->backend->leave(view, NULL);
 }
 
+PuglStatus
+puglReadPixels(PuglView* PUGL_UNUSED(view),
+               void*     PUGL_UNUSED(pixels),
+               size_t    PUGL_UNUSED(stride))
+{
+  return PUGL_UNSUPPORTED_TYPE;
+}
+
+PuglStatus
+puglStartCapture(PuglView*         PUGL_UNUSED(view),
+                 PuglGlCaptureFunc PUGL_UNUSED(func))
+{
+  return PUGL_UNSUPPORTED_TYPE;
+}
+
+PuglStatus
+puglStopCapture(PuglView* PUGL_UNUSED(view))
+{
+  return PUGL_FAILURE;
+}
+
+PuglStatus
+puglGetFrameStats(const PuglView*   PUGL_UNUSED(view),
+                  PuglGlFrameStats* PUGL_UNUSED(stats))
+{
+  return PUGL_UNSUPPORTED_TYPE;
+}
+
 const PuglBackend*
 puglGlBackend(void)
 {
@@ -325,3 +357,9 @@ puglGlBackend(void)
 
   return &backend;
 }
+
+const PuglBackend*
+puglEglBackend(void)
+{
+  return NULL;
+}
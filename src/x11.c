@@ -35,18 +35,22 @@
 #  include <X11/extensions/Xrandr.h>
 #endif
 
-#ifdef HAVE_XSYNC
-#  include <X11/extensions/sync.h>
-#  include <X11/extensions/syncconst.h>
-#endif
-
 #ifdef HAVE_XCURSOR
 #  include <X11/Xcursor/Xcursor.h>
 #  include <X11/cursorfont.h>
 #endif
 
-#include <sys/select.h>
-#include <sys/time.h>
+#ifdef HAVE_EVENTFD
+#  include <sys/eventfd.h>
+#endif
+
+#ifdef HAVE_TIMERFD
+#  include <sys/timerfd.h>
+#endif
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 
 #include <math.h>
 #include <stdbool.h>
@@ -69,36 +73,134 @@ enum WmClientStateMessageAction {
   WM_STATE_TOGGLE
 };
 
+/*
+  The thread queue is a bounded multi-producer single-consumer queue, based on
+  the bounded MPMC queue by Dmitry Vyukov.  Each cell has a sequence number
+  which is equal to the position it can next be written at when it is free,
+  or that position plus one when it contains an event.  Producers claim a
+  position with a compare and swap, so posting never waits for another thread
+  or takes a lock, though it may retry if several threads post at once.
+*/
+
 static bool
-puglInitXSync(PuglWorldInternals* impl)
-{
-#ifdef HAVE_XSYNC
-  int                 syncMajor   = 0;
-  int                 syncMinor   = 0;
-  int                 errorBase   = 0;
-  XSyncSystemCounter* counters    = NULL;
-  int                 numCounters = 0;
-
-  if (XSyncQueryExtension(impl->display, &impl->syncEventBase, &errorBase) &&
-      XSyncInitialize(impl->display, &syncMajor, &syncMinor) &&
-      (counters = XSyncListSystemCounters(impl->display, &numCounters))) {
-    for (int n = 0; n < numCounters; ++n) {
-      if (!strcmp(counters[n].name, "SERVERTIME")) {
-        impl->serverTimeCounter = counters[n].counter;
-        impl->syncSupported     = true;
-        break;
+puglQueuePush(PuglEventQueue* const  queue,
+              const Window           win,
+              const PuglEvent* const event)
+{
+  size_t           pos  = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+  PuglQueuedEvent* cell = NULL;
+
+  for (;;) {
+    cell = &queue->cells[pos & queue->mask];
+
+    const size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+    if (seq == pos) {
+      if (__atomic_compare_exchange_n(&queue->head,
+                                      &pos,
+                                      pos + 1u,
+                                      true,
+                                      __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED)) {
+        break; // Claimed this cell
       }
+    } else if ((ptrdiff_t)(seq - pos) < 0) {
+      return false; // Full
+    } else {
+      pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
     }
+  }
+
+  // Copy only the used part of the event, which may be a smaller struct
+  memset(&cell->event, 0, sizeof(cell->event));
+  memcpy(&cell->event, event, puglEventSize(event->type));
+  cell->win = win;
 
-    XSyncFreeSystemCounterList(counters);
+  __atomic_store_n(&cell->sequence, pos + 1u, __ATOMIC_RELEASE);
+  return true;
+}
+
+static bool
+puglQueuePop(PuglEventQueue* const queue, Window* const win, PuglEvent* event)
+{
+  const size_t           pos  = queue->tail;
+  PuglQueuedEvent* const cell = &queue->cells[pos & queue->mask];
+
+  const size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+  if (seq != pos + 1u) {
+    return false; // Empty, or the next event is still being written
+  }
+
+  *win   = cell->win;
+  *event = cell->event;
+
+  queue->tail = pos + 1u;
+  __atomic_store_n(&cell->sequence, pos + queue->mask + 1u, __ATOMIC_RELEASE);
+  return true;
+}
+
+/// Wake up the event loop if it has not already been woken since draining
+static void
+puglWakeUp(PuglWorldInternals* const impl)
+{
+  if (!__atomic_exchange_n(&impl->wakePending, 1, __ATOMIC_ACQ_REL)) {
+    const uint64_t one = 1u;
+    const ssize_t  r   = write(impl->wakeFds[1], &one, sizeof(one));
+    (void)r;
+  }
+}
+
+/// Number of events that can be posted from threads between updates
+static const size_t puglThreadQueueSize = 1024u;
+
+static bool
+puglInitThreadQueue(PuglWorldInternals* impl)
+{
+  PuglEventQueue* const queue = &impl->threadQueue;
+
+  if (!(queue->cells = (PuglQueuedEvent*)calloc(puglThreadQueueSize,
+                                                sizeof(PuglQueuedEvent)))) {
+    return false;
+  }
+
+  queue->mask = puglThreadQueueSize - 1u;
+  for (size_t i = 0u; i < puglThreadQueueSize; ++i) {
+    queue->cells[i].sequence = i;
+  }
+
+#ifdef HAVE_EVENTFD
+  impl->wakeFds[0] = impl->wakeFds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (impl->wakeFds[0] >= 0) {
+    return true;
   }
-#else
-  (void)impl;
 #endif
 
+  if (!pipe(impl->wakeFds)) {
+    fcntl(impl->wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(impl->wakeFds[1], F_SETFL, O_NONBLOCK);
+    return true;
+  }
+
+  free(queue->cells);
+  queue->cells     = NULL;
+  impl->wakeFds[0] = impl->wakeFds[1] = -1;
   return false;
 }
 
+/// Number of atoms in PuglX11Atoms
+#define PUGL_NUM_ATOMS 8u
+
+/// Names of atoms in PuglX11Atoms, in order (mutable for XInternAtoms)
+static char puglAtomNames[PUGL_NUM_ATOMS][32] = {
+  "CLIPBOARD",
+  "UTF8_STRING",
+  "WM_PROTOCOLS",
+  "WM_DELETE_WINDOW",
+  "_PUGL_CLIENT_MSG",
+  "_NET_WM_NAME",
+  "_NET_WM_STATE",
+  "_NET_WM_STATE_DEMANDS_ATTENTION",
+};
+
 PuglWorldInternals*
 puglInitWorldInternals(PuglWorldType type, PuglWorldFlags flags)
 {
@@ -106,36 +208,49 @@ puglInitWorldInternals(PuglWorldType type, PuglWorldFlags flags)
     XInitThreads();
   }
 
-  Display* display = XOpenDisplay(NULL);
-  if (!display) {
+  // Open the display, unless running without one
+  Display* display = NULL;
+  if (!(flags & PUGL_WORLD_HEADLESS) && !(display = XOpenDisplay(NULL))) {
     return NULL;
   }
 
   PuglWorldInternals* impl =
     (PuglWorldInternals*)calloc(1, sizeof(PuglWorldInternals));
 
-  impl->display = display;
+  impl->display    = display;
+  impl->wakeFds[0] = impl->wakeFds[1] = -1;
+
+  // Set up the queue for posting events from other threads if necessary
+  if (flags & PUGL_WORLD_THREADS) {
+    puglInitThreadQueue(impl);
+  }
 
-  // Intern the various atoms we will need
-  impl->atoms.CLIPBOARD        = XInternAtom(display, "CLIPBOARD", 0);
-  impl->atoms.UTF8_STRING      = XInternAtom(display, "UTF8_STRING", 0);
-  impl->atoms.WM_PROTOCOLS     = XInternAtom(display, "WM_PROTOCOLS", 0);
-  impl->atoms.WM_DELETE_WINDOW = XInternAtom(display, "WM_DELETE_WINDOW", 0);
-  impl->atoms.PUGL_CLIENT_MSG  = XInternAtom(display, "_PUGL_CLIENT_MSG", 0);
-  impl->atoms.NET_WM_NAME      = XInternAtom(display, "_NET_WM_NAME", 0);
-  impl->atoms.NET_WM_STATE     = XInternAtom(display, "_NET_WM_STATE", 0);
-  impl->atoms.NET_WM_STATE_DEMANDS_ATTENTION =
-    XInternAtom(display, "_NET_WM_STATE_DEMANDS_ATTENTION", 0);
+  // Intern the various atoms we will need in a single round trip
+  if (display) {
+    char* names[PUGL_NUM_ATOMS];
+    Atom  atoms[PUGL_NUM_ATOMS];
+    for (size_t i = 0u; i < PUGL_NUM_ATOMS; ++i) {
+      names[i] = puglAtomNames[i];
+    }
 
-  // Open input method
-  XSetLocaleModifiers("");
-  if (!(impl->xim = XOpenIM(display, NULL, NULL, NULL))) {
-    XSetLocaleModifiers("@im=");
-    impl->xim = XOpenIM(display, NULL, NULL, NULL);
+    XInternAtoms(display, names, (int)PUGL_NUM_ATOMS, False, atoms);
+    impl->atoms.CLIPBOARD                      = atoms[0];
+    impl->atoms.UTF8_STRING                    = atoms[1];
+    impl->atoms.WM_PROTOCOLS                   = atoms[2];
+    impl->atoms.WM_DELETE_WINDOW               = atoms[3];
+    impl->atoms.PUGL_CLIENT_MSG                = atoms[4];
+    impl->atoms.NET_WM_NAME                    = atoms[5];
+    impl->atoms.NET_WM_STATE                   = atoms[6];
+    impl->atoms.NET_WM_STATE_DEMANDS_ATTENTION = atoms[7];
   }
 
-  puglInitXSync(impl);
-  XFlush(display);
+#ifdef HAVE_TIMERFD
+  impl->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+#endif
+
+  if (display) {
+    XFlush(display);
+  }
 
   return impl;
 }
@@ -158,39 +273,430 @@ puglInitViewInternals(void)
   return impl;
 }
 
+static short
+puglFdFlagsToPollEvents(const PuglFdFlags flags)
+{
+  return (short)(((flags & PUGL_FD_READ) ? POLLIN : 0) |
+                 ((flags & PUGL_FD_WRITE) ? POLLOUT : 0));
+}
+
+static PuglFdFlags
+puglPollEventsToFdFlags(const short events)
+{
+  return (((events & (POLLIN | POLLPRI)) ? PUGL_FD_READ : 0u) |
+          ((events & POLLOUT) ? PUGL_FD_WRITE : 0u) |
+          ((events & (POLLERR | POLLHUP | POLLNVAL)) ? PUGL_FD_ERROR : 0u));
+}
+
+static PuglFdWatch*
+puglFindFdWatch(const PuglWorldInternals* impl, const int fd)
+{
+  for (size_t i = 0; i < impl->numFdWatches; ++i) {
+    if (impl->fdWatches[i].fd == fd) {
+      return &impl->fdWatches[i];
+    }
+  }
+
+  return NULL;
+}
+
+PuglStatus
+puglRegisterFd(PuglWorld* const  world,
+               const int         fd,
+               const PuglFdFlags flags,
+               const PuglFdFunc  func,
+               void* const       data)
+{
+  PuglWorldInternals* const impl  = world->impl;
+  const PuglFdWatch         watch = {fd, flags, func, data};
+
+  if (fd < 0 || !func || !(flags & (PUGL_FD_READ | PUGL_FD_WRITE))) {
+    return PUGL_BAD_PARAMETER;
+  }
+
+  PuglFdWatch* const existing = puglFindFdWatch(impl, fd);
+  if (existing) {
+    *existing = watch;
+    return PUGL_SUCCESS;
+  }
+
+  const size_t       size    = (impl->numFdWatches + 1u) * sizeof(watch);
+  PuglFdWatch* const watches = (PuglFdWatch*)realloc(impl->fdWatches, size);
+  if (!watches) {
+    return PUGL_FAILURE;
+  }
+
+  impl->fdWatches                       = watches;
+  impl->fdWatches[impl->numFdWatches++] = watch;
+  return PUGL_SUCCESS;
+}
+
+PuglStatus
+puglUnregisterFd(PuglWorld* const world, const int fd)
+{
+  PuglWorldInternals* const impl  = world->impl;
+  PuglFdWatch* const        watch = puglFindFdWatch(impl, fd);
+  if (!watch) {
+    return PUGL_FAILURE;
+  }
+
+  const size_t i = (size_t)(watch - impl->fdWatches);
+  memmove(impl->fdWatches + i,
+          impl->fdWatches + i + 1,
+          sizeof(PuglFdWatch) * (impl->numFdWatches - i - 1));
+
+  --impl->numFdWatches;
+  return PUGL_SUCCESS;
+}
+
+/// Call the functions of any ready watched descriptors in `fds`
+static void
+puglDispatchFdWatches(PuglWorld*                 world,
+                      const struct pollfd* const fds,
+                      const size_t               nfds)
+{
+  for (size_t i = 0; i < nfds; ++i) {
+    if (fds[i].revents) {
+      // Look up the watch again, since functions may (un)register descriptors
+      const PuglFdWatch* const watch = puglFindFdWatch(world->impl, fds[i].fd);
+      if (watch) {
+        watch->func(world,
+                    fds[i].fd,
+                    puglPollEventsToFdFlags(fds[i].revents),
+                    watch->data);
+      }
+    }
+  }
+}
+
+static void
+puglSiftTimerUp(PuglTimer* const timers, size_t i)
+{
+  const PuglTimer timer = timers[i];
+
+  while (i > 0) {
+    const size_t parent = (i - 1u) / 2u;
+    if (timers[parent].deadline <= timer.deadline) {
+      break;
+    }
+
+    timers[i] = timers[parent];
+    i         = parent;
+  }
+
+  timers[i] = timer;
+}
+
+static void
+puglSiftTimerDown(PuglTimer* const timers, const size_t n, size_t i)
+{
+  const PuglTimer timer = timers[i];
+
+  for (size_t child = 2u * i + 1u; child < n; child = 2u * i + 1u) {
+    const size_t right = child + 1u;
+    if (right < n && timers[right].deadline < timers[child].deadline) {
+      child = right;
+    }
+
+    if (timer.deadline <= timers[child].deadline) {
+      break;
+    }
+
+    timers[i] = timers[child];
+    i         = child;
+  }
+
+  timers[i] = timer;
+}
+
+/// Restore the heap order after the deadline of timer `i` has changed
+static void
+puglUpdateTimer(PuglWorldInternals* const w, const size_t i)
+{
+  if (i > 0 && w->timers[i].deadline < w->timers[(i - 1u) / 2u].deadline) {
+    puglSiftTimerUp(w->timers, i);
+  } else {
+    puglSiftTimerDown(w->timers, w->numTimers, i);
+  }
+}
+
+static size_t
+puglFindTimer(const PuglWorldInternals* const w,
+              const PuglView* const           view,
+              const uintptr_t                 id)
+{
+  for (size_t i = 0; i < w->numTimers; ++i) {
+    if (w->timers[i].view == view && w->timers[i].id == id) {
+      return i;
+    }
+  }
+
+  return w->numTimers;
+}
+
+static void
+puglRemoveTimer(PuglWorldInternals* const w, const size_t i)
+{
+  if (i < --w->numTimers) {
+    w->timers[i] = w->timers[w->numTimers];
+    puglUpdateTimer(w, i);
+  }
+}
+
+static void
+puglRemoveViewTimers(PuglWorldInternals* const w, const PuglView* const view)
+{
+  // Remove every timer for the view, then rebuild the heap in linear time
+  size_t n = 0u;
+  for (size_t i = 0u; i < w->numTimers; ++i) {
+    if (w->timers[i].view != view) {
+      w->timers[n++] = w->timers[i];
+    }
+  }
+
+  w->numTimers = n;
+  for (size_t i = n / 2u; i-- > 0u;) {
+    puglSiftTimerDown(w->timers, n, i);
+  }
+}
+
+#ifdef HAVE_TIMERFD
+/// Arm the timer descriptor to expire at the earliest timer deadline
+static void
+puglArmTimerFd(PuglWorld* const world)
+{
+  const double    when = world->impl->timers[0].deadline + world->startTime;
+  const double    sec  = floor(when);
+  struct timespec expiry;
+  expiry.tv_sec  = (time_t)sec;
+  expiry.tv_nsec = (long)((when - sec) * 1000000000.0);
+
+  const struct itimerspec spec = {{0, 0}, expiry};
+  timerfd_settime(world->impl->timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+#endif
+
+/// Return true if any view in a headless world has something to draw
+static bool
+puglHasPendingOffscreen(const PuglWorld* const world)
+{
+  for (size_t i = 0; i < world->numViews; ++i) {
+    const PuglInternals* const impl = world->views[i]->impl;
+    if (impl->pendingConfigure.type || impl->pendingExpose.type) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 static PuglStatus
 puglPollX11Socket(PuglWorld* world, const double timeout)
 {
-  if (XPending(world->impl->display) > 0) {
+  PuglWorldInternals* const impl    = world->impl;
+  const bool                pending = impl->display
+                                        ? XPending(impl->display) > 0
+                                        : puglHasPendingOffscreen(world);
+  if (pending && !impl->numFdWatches) {
     return PUGL_SUCCESS;
   }
 
-  const int fd   = ConnectionNumber(world->impl->display);
-  const int nfds = fd + 1;
-  int       ret  = 0;
-  fd_set    fds;
-  FD_ZERO(&fds); // NOLINT
-  FD_SET(fd, &fds);
+  // Wake up for the next timer with the timer descriptor if possible
+  bool   useTimerFd = false;
+  double wait       = timeout;
+  if (impl->numTimers) {
+#ifdef HAVE_TIMERFD
+    if (impl->timerFd >= 0) {
+      puglArmTimerFd(world);
+      useTimerFd = true;
+    }
+#endif
 
-  if (timeout < 0.0) {
-    ret = select(nfds, &fds, NULL, NULL, NULL);
-  } else {
-    const long     sec  = (long)timeout;
-    const long     usec = (long)((timeout - (double)sec) * 1e6);
-    struct timeval tv   = {sec, usec};
-    ret                 = select(nfds, &fds, NULL, NULL, &tv);
+    if (!useTimerFd) {
+      const double untilTimer =
+        MAX(0.0, impl->timers[0].deadline - puglGetTime(world));
+
+      wait = (wait < 0.0) ? untilTimer : MIN(wait, untilTimer);
+    }
+  }
+
+  // Use the stack for the descriptor set unless there are many watches
+  const bool    useWakeFd = impl->wakeFds[0] >= 0;
+  const size_t  numExtra  = (useWakeFd ? 1u : 0u) + (useTimerFd ? 1u : 0u);
+  const size_t  nfds      = 1u + impl->numFdWatches + numExtra;
+  struct pollfd localFds[16];
+
+  struct pollfd* const fds =
+    (nfds <= sizeof(localFds) / sizeof(localFds[0])
+       ? localFds
+       : (struct pollfd*)calloc(nfds, sizeof(struct pollfd)));
+
+  if (!fds) {
+    return PUGL_FAILURE;
+  }
+
+  fds[0].fd      = impl->display ? ConnectionNumber(impl->display) : -1;
+  fds[0].events  = POLLIN;
+  fds[0].revents = 0;
+  for (size_t i = 0; i < impl->numFdWatches; ++i) {
+    fds[i + 1].fd      = impl->fdWatches[i].fd;
+    fds[i + 1].events  = puglFdFlagsToPollEvents(impl->fdWatches[i].flags);
+    fds[i + 1].revents = 0;
+  }
+
+  // Add the descriptor used to wake up the loop from other threads
+  size_t n = 1u + impl->numFdWatches;
+  if (useWakeFd) {
+    fds[n].fd        = impl->wakeFds[0];
+    fds[n].events    = POLLIN;
+    fds[n++].revents = 0;
+  }
+
+#ifdef HAVE_TIMERFD
+  if (useTimerFd) {
+    fds[n].fd        = impl->timerFd;
+    fds[n].events    = POLLIN;
+    fds[n++].revents = 0;
+  }
+#endif
+
+  // Wait for a ready descriptor, or only check them if events are queued
+  int msec = -1;
+  if (pending) {
+    msec = 0;
+  } else if (wait >= 0.0) {
+    const double ms = ceil(wait * 1000.0);
+    msec            = (int)ms;
+  }
+
+  const int ret = poll(fds, (nfds_t)nfds, msec);
+  if (ret > 0) {
+    if (world->collectingStats) {
+      ++world->stats.numWakeUps;
+    }
+
+    puglDispatchFdWatches(world, fds + 1, impl->numFdWatches);
+  }
+
+  if (fds != localFds) {
+    free(fds);
   }
 
   return ret < 0 ? PUGL_UNKNOWN_ERROR : PUGL_SUCCESS;
 }
 
+static size_t
+puglHashWindow(const Window win, const size_t mask)
+{
+  // Fibonacci hashing spreads the sequential IDs X allocates to clients
+  return (size_t)(((uint64_t)win * 0x9E3779B97F4A7C15ull) >> 32u) & mask;
+}
+
+static PuglStatus
+puglResizeViewTable(PuglWorldInternals* impl, const size_t newSize)
+{
+  PuglViewEntry* const table =
+    (PuglViewEntry*)calloc(newSize, sizeof(PuglViewEntry));
+  if (!table) {
+    return PUGL_UNKNOWN_ERROR;
+  }
+
+  const size_t mask = newSize - 1u;
+  for (size_t i = 0; i < impl->viewTableSize; ++i) {
+    const PuglViewEntry entry = impl->viewTable[i];
+    if (entry.win) {
+      size_t j = puglHashWindow(entry.win, mask);
+      while (table[j].win) {
+        j = (j + 1u) & mask;
+      }
+
+      table[j] = entry;
+    }
+  }
+
+  free(impl->viewTable);
+  impl->viewTable     = table;
+  impl->viewTableSize = newSize;
+  return PUGL_SUCCESS;
+}
+
+static PuglStatus
+puglInsertView(PuglWorldInternals* impl, const Window win, PuglView* view)
+{
+  // Keep the load factor at most 1/2 so probe sequences stay short
+  if ((impl->numViewEntries + 1u) * 2u > impl->viewTableSize) {
+    const size_t     size = MAX(16u, impl->viewTableSize * 2u);
+    const PuglStatus st   = puglResizeViewTable(impl, size);
+    if (st) {
+      return st;
+    }
+  }
+
+  const size_t mask = impl->viewTableSize - 1u;
+  size_t       i    = puglHashWindow(win, mask);
+  while (impl->viewTable[i].win && impl->viewTable[i].win != win) {
+    i = (i + 1u) & mask;
+  }
+
+  if (!impl->viewTable[i].win) {
+    ++impl->numViewEntries;
+  }
+
+  impl->viewTable[i].win  = win;
+  impl->viewTable[i].view = view;
+  return PUGL_SUCCESS;
+}
+
+static void
+puglRemoveView(PuglWorldInternals* impl, const Window win)
+{
+  if (!win || !impl->viewTableSize) {
+    return;
+  }
+
+  const size_t mask = impl->viewTableSize - 1u;
+  size_t       i    = puglHashWindow(win, mask);
+  while (impl->viewTable[i].win != win) {
+    if (!impl->viewTable[i].win) {
+      return; // Not found
+    }
+
+    i = (i + 1u) & mask;
+  }
+
+  // Shift following entries back into the hole so no tombstones are needed
+  size_t j = (i + 1u) & mask;
+  while (impl->viewTable[j].win) {
+    const size_t home = puglHashWindow(impl->viewTable[j].win, mask);
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      impl->viewTable[i] = impl->viewTable[j];
+      i                  = j;
+    }
+
+    j = (j + 1u) & mask;
+  }
+
+  impl->viewTable[i].win  = 0;
+  impl->viewTable[i].view = NULL;
+  --impl->numViewEntries;
+}
+
 static PuglView*
 puglFindView(PuglWorld* world, const Window window)
 {
-  for (size_t i = 0; i < world->numViews; ++i) {
-    if (world->views[i]->impl->win == window) {
-      return world->views[i];
+  const PuglWorldInternals* const impl = world->impl;
+  if (!window || !impl->viewTableSize) {
+    return NULL;
+  }
+
+  const size_t mask = impl->viewTableSize - 1u;
+  size_t       i    = puglHashWindow(window, mask);
+  while (impl->viewTable[i].win) {
+    if (impl->viewTable[i].win == window) {
+      return impl->viewTable[i].view;
     }
+
+    i = (i + 1u) & mask;
   }
 
   return NULL;
@@ -243,40 +749,283 @@ updateSizeHints(const PuglView* view)
   return PUGL_SUCCESS;
 }
 
-#ifdef HAVE_XCURSOR
+#ifdef HAVE_XCURSOR
+static PuglStatus
+puglDefineCursorShape(PuglView* view, unsigned shape)
+{
+  PuglInternals* const impl    = view->impl;
+  PuglWorld* const     world   = view->world;
+  Display* const       display = world->impl->display;
+  const Cursor         cur     = XcursorShapeLoadCursor(display, shape);
+
+  if (cur) {
+    XDefineCursor(display, impl->win, cur);
+    XFreeCursor(display, cur);
+    return PUGL_SUCCESS;
+  }
+
+  return PUGL_FAILURE;
+}
+#endif
+
+#ifdef HAVE_XRANDR
+/// Return the refresh rate of a display mode in Hz, or zero if unknown
+static int
+puglGetModeRefreshRate(const XRRModeInfo* const mode)
+{
+  double lines = (double)mode->vTotal;
+  if (mode->modeFlags & RR_DoubleScan) {
+    lines *= 2.0;
+  }
+
+  if (mode->modeFlags & RR_Interlace) {
+    lines /= 2.0;
+  }
+
+  const double pixels = (double)mode->hTotal * lines;
+
+  return pixels > 0.0 ? (int)lround((double)mode->dotClock / pixels) : 0;
+}
+
+/// Return the refresh rate of the mode with the given ID, or zero
+static int
+puglFindModeRefreshRate(const XRRScreenResources* const resources,
+                        const RRMode                    id)
+{
+  for (int i = 0; i < resources->nmode; ++i) {
+    if (resources->modes[i].id == id) {
+      return puglGetModeRefreshRate(&resources->modes[i]);
+    }
+  }
+
+  return 0;
+}
+
+/**
+   Update the cached monitors if necessary.
+
+   This queries the area and refresh rate of every active CRTC on the given
+   screen, which costs a round trip per CRTC, so it is only done once and
+   again after the screen configuration changes.  Loading also subscribes to
+   screen change notifications, which invalidate the cache.
+
+   This requires XRandR 1.2, otherwise there are no monitors.
+*/
+static void
+puglUpdateMonitors(PuglWorld* const world, const int screen)
+{
+  PuglWorldInternals* const impl    = world->impl;
+  Display* const            display = impl->display;
+  const Window              root    = RootWindow(display, screen);
+
+  if (impl->monitorsValid && impl->monitorsScreen == screen) {
+    return;
+  }
+
+  impl->monitorsValid  = true;
+  impl->monitorsScreen = screen;
+  impl->numMonitors    = 0u;
+
+  if (!impl->xrandrEventBase) {
+    int eventBase = 0;
+    int errorBase = 0;
+    int major     = 0;
+    int minor     = 0;
+    if (!XRRQueryExtension(display, &eventBase, &errorBase) ||
+        !XRRQueryVersion(display, &major, &minor) ||
+        (major < 1 || (major == 1 && minor < 2))) {
+      return;
+    }
+
+    impl->xrandrEventBase = eventBase;
+    impl->xrandrCurrent   = major > 1 || minor >= 3;
+  }
+
+  XRRSelectInput(
+    display, root, RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask);
+
+  // Avoid probing outputs, which can take a long time, if possible
+  XRRScreenResources* const resources =
+    impl->xrandrCurrent ? XRRGetScreenResourcesCurrent(display, root)
+                        : XRRGetScreenResources(display, root);
+  if (!resources) {
+    return;
+  }
+
+  PuglMonitor* const monitors = (PuglMonitor*)realloc(
+    impl->monitors, (size_t)resources->ncrtc * sizeof(PuglMonitor));
+
+  if (monitors) {
+    impl->monitors = monitors;
+
+    for (int i = 0; i < resources->ncrtc; ++i) {
+      XRRCrtcInfo* const crtc =
+        XRRGetCrtcInfo(display, resources, resources->crtcs[i]);
+
+      if (crtc && crtc->mode != None) {
+        PuglMonitor* const monitor = &monitors[impl->numMonitors++];
+
+        monitor->rect.x      = crtc->x;
+        monitor->rect.y      = crtc->y;
+        monitor->rect.width  = crtc->width;
+        monitor->rect.height = crtc->height;
+        monitor->refreshRate = puglFindModeRefreshRate(resources, crtc->mode);
+      }
+
+      if (crtc) {
+        XRRFreeCrtcInfo(crtc);
+      }
+    }
+  }
+
+  XRRFreeScreenResources(resources);
+}
+
+/// Return true if the cached monitors do not all have the same refresh rate
+static bool
+puglHaveMixedRefreshRates(const PuglWorldInternals* const impl)
+{
+  for (size_t i = 1u; i < impl->numMonitors; ++i) {
+    if (impl->monitors[i].refreshRate != impl->monitors[0].refreshRate) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+   Set the refresh rate hint of a view from the monitor it is on.
+
+   The view is considered to be on the monitor that contains its center, given
+   in root window coordinates.  If no monitor contains it, the first is used.
+*/
+static void
+puglUpdateRefreshRate(PuglView* const view, const double x, const double y)
+{
+  PuglWorldInternals* const impl = view->world->impl;
+
+  puglUpdateMonitors(view->world, view->impl->screen);
+  if (!impl->numMonitors) {
+    return;
+  }
+
+  const PuglMonitor* monitor = &impl->monitors[0];
+  for (size_t i = 0u; i < impl->numMonitors; ++i) {
+    const PuglRect* const r = &impl->monitors[i].rect;
+    if (x >= r->x && x < r->x + r->width && y >= r->y &&
+        y < r->y + r->height) {
+      monitor = &impl->monitors[i];
+      break;
+    }
+  }
+
+  if (monitor->refreshRate > 0) {
+    view->hints[PUGL_REFRESH_RATE] = monitor->refreshRate;
+  }
+}
+
+/// Set the refresh rate hint of a top-level view from its frame in the root
+static void
+puglUpdateTopLevelRefreshRate(PuglView* const view)
+{
+  puglUpdateRefreshRate(view,
+                        view->frame.x + view->frame.width / 2.0,
+                        view->frame.y + view->frame.height / 2.0);
+}
+
+/// Set the refresh rate hint of a view from where the server says it is
+static void
+puglUpdateWindowRefreshRate(PuglView* const view)
+{
+  PuglWorldInternals* const impl = view->world->impl;
+
+  // The frame may be relative to a parent or window manager frame, so ask the
+  // server where the window is, but only if it matters (this is a round trip)
+  puglUpdateMonitors(view->world, view->impl->screen);
+  if (puglHaveMixedRefreshRates(impl)) {
+    Display* const display = impl->display;
+    const Window   root    = RootWindow(display, view->impl->screen);
+    int            rootX   = 0;
+    int            rootY   = 0;
+    Window         child   = 0;
+
+    XTranslateCoordinates(display,
+                          view->impl->win,
+                          root,
+                          (int)(view->frame.width / 2.0),
+                          (int)(view->frame.height / 2.0),
+                          &rootX,
+                          &rootY,
+                          &child);
+
+    puglUpdateRefreshRate(view, rootX, rootY);
+  } else {
+    puglUpdateRefreshRate(view, 0.0, 0.0);
+  }
+}
+
+/// Set the refresh rate hint of a realized view from the monitor it is on
+static void
+puglUpdateViewRefreshRate(PuglView* const view)
+{
+  if (view->parent) {
+    puglUpdateWindowRefreshRate(view);
+  } else {
+    puglUpdateTopLevelRefreshRate(view);
+  }
+}
+
+/// Handle an XRandR event, returning true if it was one
+static bool
+puglHandleXRandREvent(PuglWorld* const world, XEvent* const xevent)
+{
+  const int eventBase = world->impl->xrandrEventBase;
+  if (!eventBase || (xevent->type != eventBase + RRScreenChangeNotify &&
+                     xevent->type != eventBase + RRNotify)) {
+    return false;
+  }
+
+  // Reload monitors and update the refresh rate of all views
+  XRRUpdateConfiguration(xevent);
+  world->impl->monitorsValid = false;
+  for (size_t i = 0u; i < world->numViews; ++i) {
+    PuglView* const view = world->views[i];
+    if (view->impl->win) {
+      puglUpdateWindowRefreshRate(view);
+    }
+  }
+
+  return true;
+}
+#endif
+
+/// Realize a view in a headless world, which only sets up the backend
 static PuglStatus
-puglDefineCursorShape(PuglView* view, unsigned shape)
+puglRealizeOffscreen(PuglView* const view)
 {
-  PuglInternals* const impl    = view->impl;
-  PuglWorld* const     world   = view->world;
-  Display* const       display = world->impl->display;
-  const Cursor         cur     = XcursorShapeLoadCursor(display, shape);
+  PuglStatus st = PUGL_SUCCESS;
 
-  if (cur) {
-    XDefineCursor(display, impl->win, cur);
-    XFreeCursor(display, cur);
-    return PUGL_SUCCESS;
+  if ((st = view->backend->configure(view)) ||
+      (st = view->backend->create(view))) {
+    view->backend->destroy(view);
+    return st;
   }
 
-  return PUGL_FAILURE;
+  view->impl->offscreen = true;
+  puglDispatchSimpleEvent(view, PUGL_CREATE);
+
+  return PUGL_SUCCESS;
 }
-#endif
 
 PuglStatus
 puglRealize(PuglView* view)
 {
-  PuglInternals* const impl    = view->impl;
-  PuglWorld* const     world   = view->world;
-  PuglX11Atoms* const  atoms   = &view->world->impl->atoms;
-  Display* const       display = world->impl->display;
-  const int            screen  = DefaultScreen(display);
-  const Window         root    = RootWindow(display, screen);
-  const Window         parent  = view->parent ? (Window)view->parent : root;
-  XSetWindowAttributes attr    = {0};
-  PuglStatus           st      = PUGL_SUCCESS;
+  PuglInternals* const impl  = view->impl;
+  PuglWorld* const     world = view->world;
 
   // Ensure that we're unrealized and that a reasonable backend has been set
-  if (impl->win) {
+  if (puglIsRealized(view)) {
     return PUGL_FAILURE;
   }
 
@@ -294,6 +1043,18 @@ puglRealize(PuglView* view)
     view->frame.height = view->defaultHeight;
   }
 
+  if (!world->impl->display) {
+    return puglRealizeOffscreen(view);
+  }
+
+  PuglX11Atoms* const  atoms   = &view->world->impl->atoms;
+  Display* const       display = world->impl->display;
+  const int            screen  = DefaultScreen(display);
+  const Window         root    = RootWindow(display, screen);
+  const Window         parent  = view->parent ? (Window)view->parent : root;
+  XSetWindowAttributes attr    = {0};
+  PuglStatus           st      = PUGL_SUCCESS;
+
   // Center top-level windows if a position has not been set
   if (!view->parent && view->frame.x == 0.0 && view->frame.y == 0.0) {
     const int screenWidth  = DisplayWidth(display, screen);
@@ -341,18 +1102,21 @@ puglRealize(PuglView* view)
                             CWColormap | CWEventMask,
                             &attr);
 
+  // Register the window so events can be mapped back to this view
+  if ((st = puglInsertView(world->impl, impl->win, view))) {
+    XDestroyWindow(display, impl->win);
+    impl->win = 0;
+    return st;
+  }
+
   // Create the backend drawing context/surface
   if ((st = view->backend->create(view))) {
     return st;
   }
 
 #ifdef HAVE_XRANDR
-  // Set refresh rate hint to the real refresh rate
-  XRRScreenConfiguration* conf         = XRRGetScreenInfo(display, parent);
-  short                   current_rate = XRRConfigCurrentRate(conf);
-
-  view->hints[PUGL_REFRESH_RATE] = current_rate;
-  XRRFreeScreenConfigInfo(conf);
+  // Set refresh rate hint to the real refresh rate of the monitor
+  puglUpdateViewRefreshRate(view);
 #endif
 
   updateSizeHints(view);
@@ -372,16 +1136,6 @@ puglRealize(PuglView* view)
     XSetTransientForHint(display, impl->win, (Window)view->transientParent);
   }
 
-  // Create input context
-  impl->xic = XCreateIC(world->impl->xim,
-                        XNInputStyle,
-                        XIMPreeditNothing | XIMStatusNothing,
-                        XNClientWindow,
-                        impl->win,
-                        XNFocusWindow,
-                        impl->win,
-                        NULL);
-
 #ifdef HAVE_XCURSOR
   puglDefineCursorShape(view, impl->cursorShape);
 #endif
@@ -391,17 +1145,43 @@ puglRealize(PuglView* view)
   return PUGL_SUCCESS;
 }
 
+/// Queue a configure and a full redisplay for a headless view
+static void
+puglConfigureOffscreen(PuglView* const view)
+{
+  const PuglEventConfigure configure = {PUGL_CONFIGURE,
+                                        0,
+                                        view->frame.x,
+                                        view->frame.y,
+                                        view->frame.width,
+                                        view->frame.height};
+
+  view->impl->pendingConfigure.configure = configure;
+  puglPostRedisplay(view);
+}
+
 PuglStatus
 puglShow(PuglView* view)
 {
   PuglStatus st = PUGL_SUCCESS;
 
-  if (!view->impl->win) {
+  if (!puglIsRealized(view)) {
     if ((st = puglRealize(view))) {
       return st;
     }
   }
 
+  if (view->impl->offscreen) {
+    // There is no window manager, so the view is simply mapped and exposed
+    if (!view->visible) {
+      view->visible = true;
+      puglDispatchSimpleEvent(view, PUGL_MAP);
+      puglConfigureOffscreen(view);
+    }
+
+    return st;
+  }
+
   XMapRaised(view->impl->display, view->impl->win);
   puglPostRedisplay(view);
 
@@ -411,14 +1191,31 @@ puglShow(PuglView* view)
 PuglStatus
 puglHide(PuglView* view)
 {
+  if (view->impl->offscreen) {
+    if (view->visible) {
+      view->visible = false;
+      puglDispatchSimpleEvent(view, PUGL_UNMAP);
+    }
+
+    return PUGL_SUCCESS;
+  }
+
   XUnmapWindow(view->impl->display, view->impl->win);
   return PUGL_SUCCESS;
 }
 
+bool
+puglIsRealized(const PuglView* view)
+{
+  return view->impl->win || view->impl->offscreen;
+}
+
 void
 puglFreeViewInternals(PuglView* view)
 {
   if (view && view->impl) {
+    puglRemoveViewTimers(view->world->impl, view);
+
     if (view->impl->xic) {
       XDestroyIC(view->impl->xic);
     }
@@ -426,6 +1223,7 @@ puglFreeViewInternals(PuglView* view)
       view->backend->destroy(view);
     }
     if (view->impl->display) {
+      puglRemoveView(view->world->impl, view->impl->win);
       XDestroyWindow(view->impl->display, view->impl->win);
     }
     XFree(view->impl->vi);
@@ -436,10 +1234,33 @@ puglFreeViewInternals(PuglView* view)
 void
 puglFreeWorldInternals(PuglWorld* world)
 {
+  if (world->impl->glWorld) {
+    world->impl->freeGlWorld(world->impl->glWorld);
+  }
+  if (world->impl->eglWorld) {
+    world->impl->freeEglWorld(world->impl->eglWorld);
+  }
   if (world->impl->xim) {
     XCloseIM(world->impl->xim);
   }
-  XCloseDisplay(world->impl->display);
+#ifdef HAVE_TIMERFD
+  if (world->impl->timerFd >= 0) {
+    close(world->impl->timerFd);
+  }
+#endif
+  if (world->impl->wakeFds[1] != world->impl->wakeFds[0]) {
+    close(world->impl->wakeFds[1]);
+  }
+  if (world->impl->wakeFds[0] >= 0) {
+    close(world->impl->wakeFds[0]);
+  }
+  if (world->impl->display) {
+    XCloseDisplay(world->impl->display);
+  }
+  free(world->impl->threadQueue.cells);
+  free(world->impl->monitors);
+  free(world->impl->viewTable);
+  free(world->impl->fdWatches);
   free(world->impl->timers);
   free(world->impl);
 }
@@ -525,9 +1346,45 @@ keySymToSpecial(KeySym sym)
   return (PuglKey)0;
 }
 
+/// Return the input context for a view, creating it on first use
+static XIC
+puglGetInputContext(PuglView* const view)
+{
+  PuglInternals* const      impl  = view->impl;
+  PuglWorldInternals* const wimpl = view->world->impl;
+
+  if (!wimpl->ximOpened) {
+    // Open input method, which may need to talk to an input method server
+    wimpl->ximOpened = true;
+    XSetLocaleModifiers("");
+    if (!(wimpl->xim = XOpenIM(wimpl->display, NULL, NULL, NULL))) {
+      XSetLocaleModifiers("@im=");
+      wimpl->xim = XOpenIM(wimpl->display, NULL, NULL, NULL);
+    }
+  }
+
+  if (!impl->xic && wimpl->xim) {
+    impl->xic = XCreateIC(wimpl->xim,
+                          XNInputStyle,
+                          XIMPreeditNothing | XIMStatusNothing,
+                          XNClientWindow,
+                          impl->win,
+                          XNFocusWindow,
+                          impl->win,
+                          NULL);
+  }
+
+  return impl->xic;
+}
+
 static int
 lookupString(XIC xic, XEvent* xevent, char* str, KeySym* sym)
 {
+  if (!xic) {
+    // No input method, so fall back to simple lookup without composition
+    return XLookupString(&xevent->xkey, str, 7, sym, NULL);
+  }
+
   Status status = 0;
 
 #ifdef X_HAVE_UTF8_STRING
@@ -562,7 +1419,8 @@ translateKey(PuglView* view, XEvent* xevent, PuglEvent* event)
     xevent->xkey.state = state;
 
     char      sstr[8] = {0};
-    const int sfound  = lookupString(view->impl->xic, xevent, sstr, &sym);
+    const XIC xic     = puglGetInputContext(view);
+    const int sfound  = lookupString(xic, xevent, sstr, &sym);
     if (sfound > 0) {
       // Dispatch key event now
       puglDispatchEvent(view, event);
@@ -630,13 +1488,15 @@ translateEvent(PuglView* view, XEvent xevent)
     event.expose.height = xevent.xexpose.height;
     break;
   case MotionNotify:
-    event.type         = PUGL_MOTION;
-    event.motion.time  = (double)xevent.xmotion.time / 1e3;
-    event.motion.x     = xevent.xmotion.x;
-    event.motion.y     = xevent.xmotion.y;
-    event.motion.xRoot = xevent.xmotion.x_root;
-    event.motion.yRoot = xevent.xmotion.y_root;
-    event.motion.state = translateModifiers(xevent.xmotion.state);
+    event.type             = PUGL_MOTION;
+    event.motion.time      = (double)xevent.xmotion.time / 1e3;
+    event.motion.x         = xevent.xmotion.x;
+    event.motion.y         = xevent.xmotion.y;
+    event.motion.xRoot     = xevent.xmotion.x_root;
+    event.motion.yRoot     = xevent.xmotion.y_root;
+    event.motion.state     = translateModifiers(xevent.xmotion.state);
+    event.motion.firstTime = event.motion.time;
+    event.motion.count     = 1u;
     if (xevent.xmotion.is_hint == NotifyHint) {
       event.motion.flags |= PUGL_IS_HINT;
     }
@@ -737,6 +1597,10 @@ translateEvent(PuglView* view, XEvent xevent)
 PuglStatus
 puglGrabFocus(PuglView* view)
 {
+  if (!view->impl->win) {
+    return PUGL_FAILURE;
+  }
+
   XSetInputFocus(
     view->impl->display, view->impl->win, RevertToNone, CurrentTime);
   return PUGL_SUCCESS;
@@ -745,6 +1609,10 @@ puglGrabFocus(PuglView* view)
 bool
 puglHasFocus(const PuglView* view)
 {
+  if (!view->impl->win) {
+    return false;
+  }
+
   int    revertTo      = 0;
   Window focusedWindow = 0;
   XGetInputFocus(view->impl->display, &focusedWindow, &revertTo);
@@ -758,6 +1626,10 @@ puglRequestAttention(PuglView* view)
   const PuglX11Atoms* const atoms = &view->world->impl->atoms;
   XEvent                    event = {0};
 
+  if (!impl->win) {
+    return PUGL_FAILURE;
+  }
+
   event.type                 = ClientMessage;
   event.xclient.window       = impl->win;
   event.xclient.format       = 32;
@@ -781,76 +1653,97 @@ puglRequestAttention(PuglView* view)
 PuglStatus
 puglStartTimer(PuglView* view, uintptr_t id, double timeout)
 {
-#ifdef HAVE_XSYNC
-  if (view->world->impl->syncSupported) {
-    XSyncValue value;
-    XSyncIntToValue(&value, (int)floor(timeout * 1000.0));
-
-    PuglWorldInternals*  w       = view->world->impl;
-    Display* const       display = w->display;
-    const XSyncCounter   counter = w->serverTimeCounter;
-    const XSyncTestType  type    = XSyncPositiveTransition;
-    const XSyncTrigger   trigger = {counter, XSyncRelative, value, type};
-    XSyncAlarmAttributes attr    = {trigger, value, True, XSyncAlarmActive};
-    const XSyncAlarm     alarm   = XSyncCreateAlarm(display, 0x17, &attr);
-    const PuglTimer      timer   = {alarm, view, id};
-
-    if (alarm != None) {
-      for (size_t i = 0; i < w->numTimers; ++i) {
-        if (w->timers[i].view == view && w->timers[i].id == id) {
-          // Replace existing timer
-          XSyncDestroyAlarm(w->display, w->timers[i].alarm);
-          w->timers[i] = timer;
-          return PUGL_SUCCESS;
-        }
-      }
+  // Round very short periods up so a timer can not starve the event loop
+  const double period = MAX(0.001, timeout);
+
+  PuglWorldInternals* const w        = view->world->impl;
+  const double              deadline = puglGetTime(view->world) + period;
+  const size_t              i        = puglFindTimer(w, view, id);
+
+  if (i < w->numTimers) {
+    // Replace existing timer
+    w->timers[i].deadline = deadline;
+    w->timers[i].period   = period;
+    puglUpdateTimer(w, i);
+    return PUGL_SUCCESS;
+  }
 
-      // Add new timer
-      const size_t size           = ++w->numTimers * sizeof(timer);
-      w->timers                   = (PuglTimer*)realloc(w->timers, size);
-      w->timers[w->numTimers - 1] = timer;
-      return PUGL_SUCCESS;
+  if (w->numTimers == w->timersSize) {
+    const size_t     size   = MAX(16u, w->timersSize * 2u);
+    PuglTimer* const timers =
+      (PuglTimer*)realloc(w->timers, size * sizeof(PuglTimer));
+    if (!timers) {
+      return PUGL_UNKNOWN_ERROR;
     }
+
+    w->timers     = timers;
+    w->timersSize = size;
   }
-#else
-  (void)view;
-  (void)id;
-  (void)timeout;
-#endif
 
-  return PUGL_FAILURE;
+  // Add new timer
+  const PuglTimer timer = {deadline, period, view, id};
+
+  w->timers[w->numTimers] = timer;
+  puglSiftTimerUp(w->timers, w->numTimers++);
+  return PUGL_SUCCESS;
 }
 
 PuglStatus
 puglStopTimer(PuglView* view, uintptr_t id)
 {
-#ifdef HAVE_XSYNC
-  PuglWorldInternals* w = view->world->impl;
+  PuglWorldInternals* const w = view->world->impl;
+  const size_t              i = puglFindTimer(w, view, id);
+  if (i == w->numTimers) {
+    return PUGL_FAILURE;
+  }
 
-  for (size_t i = 0; i < w->numTimers; ++i) {
-    if (w->timers[i].view == view && w->timers[i].id == id) {
-      XSyncDestroyAlarm(w->display, w->timers[i].alarm);
+  puglRemoveTimer(w, i);
+  return PUGL_SUCCESS;
+}
 
-      if (i == w->numTimers - 1) {
-        memset(&w->timers[i], 0, sizeof(PuglTimer));
-      } else {
-        memmove(w->timers + i,
-                w->timers + i + 1,
-                sizeof(PuglTimer) * (w->numTimers - i - 1));
+/// Send timer events for every timer that has expired
+static PuglStatus
+puglDispatchTimers(PuglWorld* world)
+{
+  PuglWorldInternals* const w   = world->impl;
+  const double              now = puglGetTime(world);
 
-        memset(&w->timers[i], 0, sizeof(PuglTimer));
-      }
+  if (!w->numTimers || w->timers[0].deadline > now) {
+    return PUGL_SUCCESS;
+  }
 
-      --w->numTimers;
-      return PUGL_SUCCESS;
-    }
+#ifdef HAVE_TIMERFD
+  // Consume the expiration so the descriptor does not stay readable
+  if (w->timerFd >= 0) {
+    uint64_t      expirations = 0u;
+    const ssize_t r = read(w->timerFd, &expirations, sizeof(expirations));
+    (void)r;
   }
-#else
-  (void)view;
-  (void)id;
 #endif
 
-  return PUGL_FAILURE;
+  while (w->numTimers && w->timers[0].deadline <= now) {
+    PuglTimer* const top  = &w->timers[0];
+    PuglView* const  view = top->view;
+
+    PuglEvent event = {{PUGL_TIMER, 0}};
+    event.timer.id  = top->id;
+
+    // Reschedule before dispatching, since the handler may change timers
+    top->deadline += top->period;
+    if (top->deadline <= now) {
+      // Missed at least one period, skip ahead rather than sending a burst
+      top->deadline = now + top->period;
+    }
+
+    puglSiftTimerDown(w->timers, w->numTimers, 0);
+    if (world->collectingStats) {
+      ++world->stats.numTimerFires;
+    }
+
+    puglDispatchEvent(view, &event);
+  }
+
+  return PUGL_SUCCESS;
 }
 
 static XEvent
@@ -899,6 +1792,10 @@ puglEventToX(PuglView* view, const PuglEvent* event)
 PuglStatus
 puglSendEvent(PuglView* view, const PuglEvent* event)
 {
+  if (!view->impl->win) {
+    return PUGL_FAILURE;
+  }
+
   XEvent xev = puglEventToX(view, event);
 
   if (xev.type) {
@@ -912,10 +1809,41 @@ puglSendEvent(PuglView* view, const PuglEvent* event)
   return PUGL_UNSUPPORTED_TYPE;
 }
 
+PuglStatus
+puglPostEventFromThread(PuglView* view, const PuglEvent* event)
+{
+  PuglWorldInternals* const impl = view->world->impl;
+  const Window              win  = view->impl->win;
+
+  if (!impl->threadQueue.cells || !win ||
+      !puglQueuePush(&impl->threadQueue, win, event)) {
+    return PUGL_FAILURE;
+  }
+
+  puglWakeUp(impl);
+  return PUGL_SUCCESS;
+}
+
+PuglStatus
+puglPostRedisplayFromThread(PuglView* view, const PuglRect rect)
+{
+  PuglEvent event     = {{PUGL_EXPOSE, 0}};
+  event.expose.x      = rect.x;
+  event.expose.y      = rect.y;
+  event.expose.width  = rect.width;
+  event.expose.height = rect.height;
+
+  return puglPostEventFromThread(view, &event);
+}
+
 #ifndef PUGL_DISABLE_DEPRECATED
 PuglStatus
 puglWaitForEvent(PuglView* view)
 {
+  if (!view->impl->display) {
+    return PUGL_FAILURE;
+  }
+
   XEvent xevent;
   XPeekEvent(view->impl->display, &xevent);
   return PUGL_SUCCESS;
@@ -938,6 +1866,97 @@ mergeExposeEvents(PuglEventExpose* dst, const PuglEventExpose* src)
   }
 }
 
+/// Add `expose` to the expose and damaged region to be drawn after the loop
+static void
+addPendingExpose(PuglView* view, const PuglEventExpose* expose)
+{
+  const PuglRect rect = {expose->x, expose->y, expose->width, expose->height};
+
+  mergeExposeEvents(&view->impl->pendingExpose.expose, expose);
+  puglRegionAdd(&view->impl->pendingDamage, rect);
+}
+
+/// Add `expose` to the region to be restored from retained contents
+static void
+addPendingRestore(PuglView* view, const PuglEventExpose* expose)
+{
+  const PuglRect rect = {expose->x, expose->y, expose->width, expose->height};
+
+  mergeExposeEvents(&view->impl->pendingRestore.expose, expose);
+  puglRegionAdd(&view->impl->pendingRestoreDamage, rect);
+}
+
+static void
+mergeMotionEvents(PuglEventMotion* dst, const PuglEventMotion* src)
+{
+  if (!dst->type) {
+    *dst = *src;
+  } else {
+    const double   firstTime = dst->firstTime;
+    const uint32_t count     = dst->count + src->count;
+
+    *dst           = *src;
+    dst->firstTime = firstTime;
+    dst->count     = count;
+  }
+}
+
+/// Dispatch any motion merged for `view` so far, to preserve event order
+static void
+flushPendingMotion(PuglView* view)
+{
+  if (view->impl->pendingMotion.type) {
+    const PuglEvent motion = view->impl->pendingMotion;
+
+    view->impl->pendingMotion.type = PUGL_NOTHING;
+    puglDispatchEvent(view, &motion);
+  }
+}
+
+/// Dispatch events posted from other threads, returning true if there were any
+static bool
+puglDrainThreadQueue(PuglWorld* world)
+{
+  PuglWorldInternals* const impl = world->impl;
+  if (!impl->threadQueue.cells) {
+    return false;
+  }
+
+  // Drain the descriptor before clearing the flag, so that a wake-up posted
+  // in between is left to be read next time rather than being lost
+  uint64_t value = 0u;
+  while (read(impl->wakeFds[0], &value, sizeof(value)) > 0) {
+  }
+
+  __atomic_exchange_n(&impl->wakePending, 0, __ATOMIC_ACQ_REL);
+
+  // Drain at most one queue's worth, so busy producers can't stall the loop
+  Window    win   = 0;
+  PuglEvent event = {{PUGL_NOTHING, 0}};
+  size_t    n     = 0u;
+  for (; n <= impl->threadQueue.mask; ++n) {
+    if (!puglQueuePop(&impl->threadQueue, &win, &event)) {
+      break;
+    }
+
+    PuglView* const view = puglFindView(world, win);
+    if (!view) {
+      continue; // View was freed after the event was posted
+    }
+
+    if (event.type == PUGL_EXPOSE) {
+      if (view->visible) {
+        addPendingExpose(view, &event.expose);
+      }
+    } else {
+      flushPendingMotion(view);
+      puglDispatchEvent(view, &event);
+    }
+  }
+
+  return n > 0u;
+}
+
 static void
 handleSelectionNotify(const PuglWorld* world, PuglView* view)
 {
@@ -1007,6 +2026,8 @@ handleSelectionRequest(const PuglWorld*              world,
 static void
 flushExposures(PuglWorld* world)
 {
+  puglTrace(world, NULL, PUGL_TRACE_EXPOSURES, PUGL_NOTHING, true);
+
   for (size_t i = 0; i < world->numViews; ++i) {
     PuglView* const view = world->views[i];
 
@@ -1014,64 +2035,102 @@ flushExposures(PuglWorld* world)
       puglDispatchSimpleEvent(view, PUGL_UPDATE);
     }
 
-    const PuglEvent configure = view->impl->pendingConfigure;
-    const PuglEvent expose    = view->impl->pendingExpose;
+    PuglInternals* const impl      = view->impl;
+    const PuglEvent      configure = impl->pendingConfigure;
+    PuglEvent            expose    = impl->pendingExpose;
+    PuglEvent            restore   = impl->pendingRestore;
 
-    view->impl->pendingConfigure.type = PUGL_NOTHING;
-    view->impl->pendingExpose.type    = PUGL_NOTHING;
+    impl->pendingConfigure.type = PUGL_NOTHING;
+    impl->pendingExpose.type    = PUGL_NOTHING;
+    impl->pendingRestore.type   = PUGL_NOTHING;
 
-    if (configure.type || expose.type) {
-      view->backend->enter(view, expose.type ? &expose.expose : NULL);
-      puglDispatchEventInContext(view, &configure);
-      puglDispatchEventInContext(view, &expose);
-      view->backend->leave(view, expose.type ? &expose.expose : NULL);
+    if (restore.type && !impl->retained) {
+      // Contents have been lost, so the application must draw everything
+      for (size_t r = 0; r < impl->pendingRestoreDamage.numRects; ++r) {
+        puglRegionAdd(&impl->pendingDamage,
+                      impl->pendingRestoreDamage.rects[r]);
+      }
+
+      mergeExposeEvents(&expose.expose, &restore.expose);
+      impl->pendingRestoreDamage.numRects = 0;
+      restore.type                        = PUGL_NOTHING;
     }
-  }
-}
 
-static bool
-handleTimerEvent(PuglWorld* world, XEvent xevent)
-{
-#ifdef HAVE_XSYNC
-  if (xevent.type == world->impl->syncEventBase + XSyncAlarmNotify) {
-    XSyncAlarmNotifyEvent* notify = ((XSyncAlarmNotifyEvent*)&xevent);
-
-    for (size_t i = 0; i < world->impl->numTimers; ++i) {
-      if (world->impl->timers[i].alarm == notify->alarm) {
-        PuglEvent event = {{PUGL_TIMER, 0}};
-        event.timer.id  = world->impl->timers[i].id;
-        puglDispatchEvent(world->impl->timers[i].view,
-                          (const PuglEvent*)&event);
+    if (expose.type) {
+      // Move damage to the view so it can be used for drawing and queried
+      view->damage                 = impl->pendingDamage;
+      impl->pendingDamage.numRects = 0;
+    }
+
+    if (restore.type) {
+      // Move restore region to be presented along with any damage
+      impl->restore                       = impl->pendingRestoreDamage;
+      impl->pendingRestoreDamage.numRects = 0;
+    }
+
+    // The backend draws the expose, or only restores if there is none
+    const PuglEventExpose* const drawn =
+      expose.type ? &expose.expose : restore.type ? &restore.expose : NULL;
+
+    if (configure.type || drawn) {
+      puglEnterBackend(view, drawn);
+      if (expose.type) {
+        // The backend may have added damage, for example from older buffers
+        for (size_t r = 0; r < view->damage.numRects; ++r) {
+          const PuglRect*       rect   = &view->damage.rects[r];
+          const PuglEventExpose damage = {PUGL_EXPOSE,
+                                          0,
+                                          rect->x,
+                                          rect->y,
+                                          rect->width,
+                                          rect->height};
+
+          mergeExposeEvents(&expose.expose, &damage);
+        }
       }
+
+      puglDispatchEventInContext(view, &configure);
+      puglDispatchEventInContext(view, &expose);
+      puglLeaveBackend(view, drawn);
     }
 
-    return true;
+    view->damage.numRects  = 0;
+    impl->restore.numRects = 0;
   }
-#else
-  (void)world;
-  (void)xevent;
-#endif
 
-  return false;
+  puglTrace(world, NULL, PUGL_TRACE_EXPOSURES, PUGL_NOTHING, false);
 }
 
 static PuglStatus
 puglDispatchX11Events(PuglWorld* world)
 {
+  puglTrace(world, NULL, PUGL_TRACE_DISPATCH, PUGL_NOTHING, true);
+
   const PuglX11Atoms* const atoms = &world->impl->atoms;
 
   // Flush output to the server once at the start
   Display* display = world->impl->display;
-  XFlush(display);
+  if (display) {
+    XFlush(display);
+    if (world->collectingStats) {
+      ++world->stats.numFlushes;
+    }
+  }
+
+  // Handle events posted from other threads, which may have woken us up
+  puglDrainThreadQueue(world);
 
   // Process all queued events (without further flushing)
-  while (XEventsQueued(display, QueuedAfterReading) > 0) {
+  bool mergedMotion = false;
+  while (display && XEventsQueued(display, QueuedAfterReading) > 0) {
     XEvent xevent;
     XNextEvent(display, &xevent);
 
-    if (handleTimerEvent(world, xevent)) {
+#ifdef HAVE_XRANDR
+    if (puglHandleXRandREvent(world, &xevent)) {
       continue;
     }
+#endif
 
     PuglView* view = puglFindView(world, xevent.xany.window);
     if (!view) {
@@ -1088,9 +2147,14 @@ puglDispatchX11Events(PuglWorld* world)
         continue;
       }
     } else if (xevent.type == FocusIn) {
-      XSetICFocus(impl->xic);
+      const XIC xic = puglGetInputContext(view);
+      if (xic) {
+        XSetICFocus(xic);
+      }
     } else if (xevent.type == FocusOut) {
-      XUnsetICFocus(impl->xic);
+      if (impl->xic) {
+        XUnsetICFocus(impl->xic);
+      }
     } else if (xevent.type == SelectionClear) {
       puglSetBlob(&view->clipboard, NULL, 0);
     } else if (xevent.type == SelectionNotify &&
@@ -1102,20 +2166,49 @@ puglDispatchX11Events(PuglWorld* world)
       handleSelectionRequest(world, view, &xevent.xselectionrequest);
     }
 
+    // Key presses with text dispatch the key event early, so flush motion first
+    if (xevent.type == KeyPress || xevent.type == KeyRelease) {
+      flushPendingMotion(view);
+    }
+
     // Translate X11 event to Pugl event
     const PuglEvent event = translateEvent(view, xevent);
 
-    if (event.type == PUGL_EXPOSE) {
+    if (event.type == PUGL_EXPOSE && !xevent.xexpose.send_event &&
+        view->hints[PUGL_RETAIN_CONTENTS]) {
+      // Expand system expose to be restored after loop if possible
+      addPendingRestore(view, &event.expose);
+    } else if (event.type == PUGL_EXPOSE) {
       // Expand expose event to be dispatched after loop
-      mergeExposeEvents(&view->impl->pendingExpose.expose, &event.expose);
+      addPendingExpose(view, &event.expose);
     } else if (event.type == PUGL_CONFIGURE) {
       // Expand configure event to be dispatched after loop
+      if (event.configure.width != view->frame.width ||
+          event.configure.height != view->frame.height) {
+        view->impl->retained = false;
+      }
+
       view->impl->pendingConfigure = event;
       view->frame.x                = event.configure.x;
       view->frame.y                = event.configure.y;
       view->frame.width            = event.configure.width;
       view->frame.height           = event.configure.height;
+#ifdef HAVE_XRANDR
+      // Only synthetic events from the window manager have root coordinates,
+      // otherwise the position may be relative to a parent or frame window
+      if (!view->parent && xevent.xconfigure.send_event) {
+        puglUpdateTopLevelRefreshRate(view);
+      } else {
+        puglUpdateWindowRefreshRate(view);
+      }
+#endif
+    } else if (event.type == PUGL_MOTION && view->hints[PUGL_COMPRESS_MOTION]) {
+      // Merge motion to be dispatched before the next event or after the loop
+      mergeMotionEvents(&view->impl->pendingMotion.motion, &event.motion);
+      mergedMotion = true;
     } else if (event.type == PUGL_MAP && view->parent) {
+      flushPendingMotion(view);
+
       XWindowAttributes attrs;
       XGetWindowAttributes(view->impl->display, view->impl->win, &attrs);
 
@@ -1126,10 +2219,17 @@ puglDispatchX11Events(PuglWorld* world)
       puglDispatchEvent(view, &event);
     } else {
       // Dispatch event to application immediately
+      flushPendingMotion(view);
       puglDispatchEvent(view, &event);
     }
   }
 
+  // Dispatch the latest motion for any views that had motion merged
+  for (size_t i = 0; mergedMotion && i < world->numViews; ++i) {
+    flushPendingMotion(world->views[i]);
+  }
+
+  puglTrace(world, NULL, PUGL_TRACE_DISPATCH, PUGL_NOTHING, false);
   return PUGL_SUCCESS;
 }
 
@@ -1147,26 +2247,42 @@ puglUpdate(PuglWorld* world, double timeout)
   const double startTime = puglGetTime(world);
   PuglStatus   st        = PUGL_SUCCESS;
 
+  puglTrace(world, NULL, PUGL_TRACE_UPDATE, PUGL_NOTHING, true);
   world->impl->dispatchingEvents = true;
+  puglBeginEventBatches(world);
+  if (world->collectingStats) {
+    ++world->stats.numUpdates;
+  }
+
+  // Handle events posted from other threads, and don't block if there were any
+  if (puglDrainThreadQueue(world) && timeout < 0.0) {
+    timeout = 0.0;
+  }
 
   if (timeout < 0.0) {
     st = puglPollX11Socket(world, timeout);
     st = st ? st : puglDispatchX11Events(world);
+    st = st ? st : puglDispatchTimers(world);
   } else if (timeout <= 0.001) {
     st = puglDispatchX11Events(world);
+    st = st ? st : puglDispatchTimers(world);
   } else {
     const double endTime = startTime + timeout - 0.001;
     for (double t = startTime; t < endTime; t = puglGetTime(world)) {
       if ((st = puglPollX11Socket(world, endTime - t)) ||
-          (st = puglDispatchX11Events(world))) {
+          (st = puglDispatchX11Events(world)) ||
+          (st = puglDispatchTimers(world))) {
         break;
       }
     }
   }
 
+  // Deliver input before drawing, since it is likely to change what is drawn
+  puglFlushEventBatches(world);
   flushExposures(world);
 
   world->impl->dispatchingEvents = false;
+  puglTrace(world, NULL, PUGL_TRACE_UPDATE, PUGL_NOTHING, false);
 
   return st;
 }
@@ -1194,9 +2310,10 @@ puglPostRedisplayRect(PuglView* view, PuglRect rect)
   const PuglEventExpose event = {
     PUGL_EXPOSE, 0, rect.x, rect.y, rect.width, rect.height};
 
-  if (view->world->impl->dispatchingEvents) {
-    // Currently dispatching events, add/expand expose for the loop end
-    mergeExposeEvents(&view->impl->pendingExpose.expose, &event);
+  if (view->world->impl->dispatchingEvents ||
+      (view->impl->offscreen && view->visible)) {
+    // Currently dispatching events or headless, add/expand expose for the end
+    addPendingExpose(view, &event);
   } else if (view->visible) {
     // Not dispatching events, send an X expose so we wake up next time
     return puglSendEvent(view, (const PuglEvent*)&event);
@@ -1248,7 +2365,22 @@ puglSetFrame(PuglView* view, const PuglRect frame)
     }
   }
 
+  if (frame.width != view->frame.width || frame.height != view->frame.height) {
+    view->impl->retained = false;
+  }
+
   view->frame = frame;
+
+#ifdef HAVE_XRANDR
+  if (view->impl->win && !view->parent) {
+    puglUpdateTopLevelRefreshRate(view);
+  }
+#endif
+
+  if (view->impl->offscreen) {
+    puglConfigureOffscreen(view);
+  }
+
   return PUGL_SUCCESS;
 }
 
@@ -1314,7 +2446,8 @@ puglGetClipboard(PuglView* const    view,
   PuglInternals* const      impl  = view->impl;
   const PuglX11Atoms* const atoms = &view->world->impl->atoms;
 
-  const Window owner = XGetSelectionOwner(impl->display, atoms->CLIPBOARD);
+  const Window owner =
+    impl->win ? XGetSelectionOwner(impl->display, atoms->CLIPBOARD) : None;
   if (owner != None && owner != impl->win) {
     // Clear internal selection
     puglSetBlob(&view->clipboard, NULL, 0);
@@ -1350,7 +2483,11 @@ puglSetClipboard(PuglView* const   view,
     return st;
   }
 
-  XSetSelectionOwner(impl->display, atoms->CLIPBOARD, impl->win, CurrentTime);
+  if (impl->win) {
+    XSetSelectionOwner(
+      impl->display, atoms->CLIPBOARD, impl->win, CurrentTime);
+  }
+
   return PUGL_SUCCESS;
 }
 
@@ -41,21 +41,80 @@ typedef struct {
 } PuglX11Atoms;
 
 typedef struct {
-  XID       alarm;
+  double    deadline; ///< Time of next expiration, from puglGetTime()
+  double    period;   ///< Timer period in seconds
   PuglView* view;
   uintptr_t id;
 } PuglTimer;
 
+typedef struct {
+  int         fd;
+  PuglFdFlags flags;
+  PuglFdFunc  func;
+  void*       data;
+} PuglFdWatch;
+
+typedef struct {
+  Window    win;
+  PuglView* view;
+} PuglViewEntry;
+
+typedef struct {
+  size_t    sequence; ///< Position this cell is ready for, see x11.c
+  Window    win;
+  PuglEvent event;
+} PuglQueuedEvent;
+
+/// Bounded lock-free queue for events posted from other threads
+typedef struct {
+  PuglQueuedEvent* cells;
+  size_t           mask; ///< Number of cells minus one
+  size_t           head; ///< Position of next write, shared by producers
+  size_t           tail; ///< Position of next read, only used by consumer
+} PuglEventQueue;
+
+/// OpenGL backend state shared by all views in a world, see x11_gl.c
+typedef struct PuglX11GlWorldImpl PuglX11GlWorld;
+
+/// EGL backend state shared by all views in a world, see x11_egl.c
+typedef struct PuglX11EglWorldImpl PuglX11EglWorld;
+
+/// A monitor, which is the area of the root window shown by a CRTC
+typedef struct {
+  PuglRect rect;        ///< Area in root window coordinates
+  int      refreshRate; ///< Refresh rate in Hz, or zero if unknown
+} PuglMonitor;
+
 struct PuglWorldInternalsImpl {
-  Display*     display;
-  PuglX11Atoms atoms;
-  XIM          xim;
-  PuglTimer*   timers;
-  size_t       numTimers;
-  XID          serverTimeCounter;
-  int          syncEventBase;
-  bool         syncSupported;
-  bool         dispatchingEvents;
+  Display*       display;
+  PuglX11Atoms   atoms;
+  XIM            xim;
+  bool           ximOpened;       ///< True if opening xim has been attempted
+  PuglMonitor*   monitors;        ///< Cached monitors, or null
+  size_t         numMonitors;     ///< Number of cached monitors
+  bool           monitorsValid;   ///< True if cached monitors are up to date
+  int            monitorsScreen;  ///< Screen of cached monitors
+  int            xrandrEventBase; ///< XRandR event base, or zero
+  bool           xrandrCurrent;   ///< True if XRandR 1.3 is supported
+  PuglTimer*     timers; ///< Binary min-heap ordered by deadline
+  size_t         numTimers;
+  size_t         timersSize;
+  PuglFdWatch*   fdWatches;
+  size_t         numFdWatches;
+  PuglViewEntry* viewTable;
+  size_t         viewTableSize;
+  size_t         numViewEntries;
+  PuglEventQueue threadQueue;
+  int            wakeFds[2];
+  int            wakePending;
+#ifdef HAVE_TIMERFD
+  int timerFd;
+#endif
+  bool             dispatchingEvents;
+  PuglX11GlWorld*  glWorld;  ///< OpenGL backend state, or null
+  PuglX11EglWorld* eglWorld; ///< EGL backend state, or null
+  void (*freeGlWorld)(PuglX11GlWorld* glWorld);
+  void (*freeEglWorld)(PuglX11EglWorld* eglWorld);
 };
 
 struct PuglInternalsImpl {
@@ -66,6 +125,13 @@ struct PuglInternalsImpl {
   PuglSurface* surface;
   PuglEvent    pendingConfigure;
   PuglEvent    pendingExpose;
+  PuglRegion   pendingDamage;
+  PuglEvent    pendingRestore; ///< System expose to restore from contents
+  PuglRegion   pendingRestoreDamage;
+  PuglRegion   restore;   ///< Region to restore from contents for drawing
+  bool         retained;  ///< True if the backend has kept the last frame
+  bool         offscreen; ///< True if realized without a window (headless)
+  PuglEvent    pendingMotion;
   int          screen;
 #ifdef HAVE_XCURSOR
   unsigned cursorShape;
@@ -14,8 +14,11 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include "types.h"
 #include "x11.h"
+#include "x11_image.h"
 
 #include "pugl/cairo.h"
 #include "pugl/pugl.h"
@@ -24,14 +27,351 @@
 #include <cairo-xlib.h>
 #include <cairo.h>
 
+#include <pthread.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 
+#define PUGL_CAIRO_TILE_SIZE 256
+
+/// State for drawing tiles of a view with a pool of threads
+typedef struct {
+  PuglCairoTileFunc func;
+  pthread_t*        threads;    ///< Worker threads
+  unsigned          numThreads; ///< Number of worker threads
+  pthread_mutex_t   mutex;      ///< Protects everything below
+  pthread_cond_t    workCond;   ///< Signalled when there is work or on exit
+  pthread_cond_t    doneCond;   ///< Signalled when all tiles are drawn
+  cairo_surface_t*  image;      ///< Image of the whole view
+  cairo_surface_t** surfaces;   ///< Surface for each tile in the image
+  PuglRect*         rects;      ///< Area of each tile in the view
+  size_t            numTiles;   ///< Number of tiles in the image
+  size_t*           queue;      ///< Indices of tiles to draw in this frame
+  size_t            queueSize;  ///< Number of tiles to draw in this frame
+  size_t            next;       ///< Position of next tile to draw in queue
+  size_t            numDone;    ///< Number of tiles drawn in this frame
+  PuglRegion        clip;       ///< Region to draw in this frame
+  bool              exiting;    ///< True if workers should exit
+} PuglX11CairoTiles;
+
 typedef struct {
   cairo_surface_t* back;
   cairo_surface_t* front;
   cairo_t*         cr;
+  int              width;  ///< Width of surfaces
+  int              height; ///< Height of surfaces
+
+  PuglX11CairoTiles* tiles; ///< Tiled drawing state, or null
+#ifdef HAVE_XSHM
+  XShmSegmentInfo  shmInfo;    ///< Shared memory segment of image
+  XImage*          image;      ///< Image in shared memory, or null
+  GC               gc;         ///< Graphics context for putting image
+  cairo_surface_t* shmSurface; ///< Cairo surface for image data
+  bool             shmFailed;  ///< True if shared memory is unusable
+  bool             putPending; ///< True if the server may be reading image
+#endif
 } PuglX11CairoSurface;
 
+/// Clip `cr` to the damaged region of the view, or the expose if it has none
+static void
+puglX11CairoClip(const PuglView*        view,
+                 cairo_t*               cr,
+                 const PuglEventExpose* expose)
+{
+  if (view->damage.numRects) {
+    for (size_t i = 0; i < view->damage.numRects; ++i) {
+      const PuglRect* const r = &view->damage.rects[i];
+      cairo_rectangle(cr, r->x, r->y, r->width, r->height);
+    }
+  } else {
+    cairo_rectangle(cr, expose->x, expose->y, expose->width, expose->height);
+  }
+
+  cairo_clip(cr);
+}
+
+/// Clip `cr` to the damaged region and the region being restored
+static void
+puglX11CairoClipPresent(const PuglView*        view,
+                        cairo_t*               cr,
+                        const PuglEventExpose* expose)
+{
+  const PuglRegion* const restore = &view->impl->restore;
+
+  for (size_t i = 0; i < restore->numRects; ++i) {
+    const PuglRect* const r = &restore->rects[i];
+    cairo_rectangle(cr, r->x, r->y, r->width, r->height);
+  }
+
+  if (view->damage.numRects || !restore->numRects) {
+    puglX11CairoClip(view, cr, expose);
+  } else {
+    cairo_clip(cr);
+  }
+}
+
+/// Note that the contents are kept if the whole view has just been drawn
+static void
+puglX11CairoUpdateRetained(PuglView* view)
+{
+  for (size_t i = 0; i < view->damage.numRects; ++i) {
+    const PuglRect* const r = &view->damage.rects[i];
+    if (r->x <= 0.0 && r->y <= 0.0 && r->x + r->width >= view->frame.width &&
+        r->y + r->height >= view->frame.height) {
+      view->impl->retained = true;
+    }
+  }
+}
+
+/// Return true if two rectangles overlap
+static bool
+puglX11CairoRectsOverlap(const PuglRect a, const PuglRect b)
+{
+  return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height &&
+         b.y < a.y + a.height;
+}
+
+/// Free the image and tile surfaces, which depend on the size of the view
+static void
+puglX11CairoFreeTileSurfaces(PuglX11CairoTiles* const tiles)
+{
+  for (size_t i = 0; i < tiles->numTiles; ++i) {
+    cairo_surface_destroy(tiles->surfaces[i]);
+  }
+
+  cairo_surface_destroy(tiles->image);
+  free(tiles->queue);
+  free(tiles->rects);
+  free(tiles->surfaces);
+  tiles->image    = NULL;
+  tiles->surfaces = NULL;
+  tiles->rects    = NULL;
+  tiles->queue    = NULL;
+  tiles->numTiles = 0;
+}
+
+/**
+   Create an image of the whole view, and a surface for each tile of it.
+
+   The tile surfaces share the memory of the image, so tiles can be drawn in
+   parallel without any copying, then the whole image painted at once.
+*/
+static PuglStatus
+puglX11CairoOpenTiles(PuglX11CairoTiles* const tiles,
+                      const int                width,
+                      const int                height)
+{
+  if (tiles->image && cairo_image_surface_get_width(tiles->image) == width &&
+      cairo_image_surface_get_height(tiles->image) == height) {
+    return PUGL_SUCCESS;
+  }
+
+  puglX11CairoFreeTileSurfaces(tiles);
+
+  const int    size    = PUGL_CAIRO_TILE_SIZE;
+  const size_t numCols = (size_t)((width + size - 1) / size);
+  const size_t numRows = (size_t)((height + size - 1) / size);
+  const size_t count   = numCols * numRows;
+
+  tiles->image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+
+  tiles->surfaces = (cairo_surface_t**)calloc(count, sizeof(cairo_surface_t*));
+  tiles->rects    = (PuglRect*)calloc(count, sizeof(PuglRect));
+  tiles->queue    = (size_t*)calloc(count, sizeof(size_t));
+
+  if (cairo_surface_status(tiles->image) || !tiles->surfaces ||
+      !tiles->rects || !tiles->queue) {
+    puglX11CairoFreeTileSurfaces(tiles);
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  unsigned char* const data   = cairo_image_surface_get_data(tiles->image);
+  const int            stride = cairo_image_surface_get_stride(tiles->image);
+
+  for (int y = 0; y < height; y += size) {
+    for (int x = 0; x < width; x += size) {
+      const int tileWidth  = width - x < size ? width - x : size;
+      const int tileHeight = height - y < size ? height - y : size;
+
+      PuglRect* const rect = &tiles->rects[tiles->numTiles];
+      rect->x              = x;
+      rect->y              = y;
+      rect->width          = tileWidth;
+      rect->height         = tileHeight;
+
+      tiles->surfaces[tiles->numTiles++] =
+        cairo_image_surface_create_for_data(data + (ptrdiff_t)y * stride +
+                                              (ptrdiff_t)x * 4,
+                                            CAIRO_FORMAT_ARGB32,
+                                            tileWidth,
+                                            tileHeight,
+                                            stride);
+    }
+  }
+
+  return PUGL_SUCCESS;
+}
+
+/// Draw a tile, called from any thread with the mutex unlocked
+static void
+puglX11CairoDrawTile(PuglView* const view, const size_t index)
+{
+  PuglX11CairoSurface* const surface =
+    (PuglX11CairoSurface*)view->impl->surface;
+
+  PuglX11CairoTiles* const tiles = surface->tiles;
+  const PuglRect* const    rect  = &tiles->rects[index];
+  cairo_t* const           cr    = cairo_create(tiles->surfaces[index]);
+
+  // Set up the context so that the tile is drawn in view coordinates
+  cairo_translate(cr, -rect->x, -rect->y);
+  for (size_t i = 0; i < tiles->clip.numRects; ++i) {
+    const PuglRect* const r = &tiles->clip.rects[i];
+    cairo_rectangle(cr, r->x, r->y, r->width, r->height);
+  }
+
+  cairo_clip(cr);
+  tiles->func(view, cr, *rect);
+  cairo_destroy(cr);
+  cairo_surface_flush(tiles->surfaces[index]);
+}
+
+/// Take tiles from the queue and draw them until there are none left
+static void
+puglX11CairoDrawQueuedTiles(PuglView* const view)
+{
+  PuglX11CairoSurface* const surface =
+    (PuglX11CairoSurface*)view->impl->surface;
+
+  PuglX11CairoTiles* const tiles = surface->tiles;
+
+  while (tiles->next < tiles->queueSize) {
+    const size_t index = tiles->queue[tiles->next++];
+
+    pthread_mutex_unlock(&tiles->mutex);
+    puglX11CairoDrawTile(view, index);
+    pthread_mutex_lock(&tiles->mutex);
+
+    if (++tiles->numDone == tiles->queueSize) {
+      pthread_cond_signal(&tiles->doneCond);
+    }
+  }
+}
+
+static void*
+puglX11CairoTileWorker(void* const data)
+{
+  PuglView* const            view = (PuglView*)data;
+  PuglX11CairoSurface* const surface =
+    (PuglX11CairoSurface*)view->impl->surface;
+
+  PuglX11CairoTiles* const tiles = surface->tiles;
+
+  pthread_mutex_lock(&tiles->mutex);
+  while (!tiles->exiting) {
+    puglX11CairoDrawQueuedTiles(view);
+    pthread_cond_wait(&tiles->workCond, &tiles->mutex);
+  }
+  pthread_mutex_unlock(&tiles->mutex);
+
+  return NULL;
+}
+
+/**
+   Draw the tiles of the view that intersect the damage with the tile function.
+
+   The tiles are drawn by the worker threads and this one, then the image is
+   painted with `cr`, which is already clipped to the damage.
+*/
+static PuglStatus
+puglX11CairoDrawTiles(PuglView* const              view,
+                      cairo_t* const               cr,
+                      const PuglEventExpose* const expose)
+{
+  PuglX11CairoSurface* const surface =
+    (PuglX11CairoSurface*)view->impl->surface;
+
+  PuglX11CairoTiles* const tiles = surface->tiles;
+  PuglStatus               st    = PUGL_SUCCESS;
+
+  if ((st = puglX11CairoOpenTiles(
+         tiles, (int)view->frame.width, (int)view->frame.height))) {
+    return st;
+  }
+
+  pthread_mutex_lock(&tiles->mutex);
+
+  // Set up the clip region and queue every tile that intersects it
+  if (view->damage.numRects) {
+    tiles->clip = view->damage;
+  } else {
+    const PuglRect rect = {expose->x, expose->y, expose->width, expose->height};
+    tiles->clip.rects[0] = rect;
+    tiles->clip.numRects = 1;
+  }
+
+  tiles->queueSize = 0;
+  for (size_t t = 0; t < tiles->numTiles; ++t) {
+    for (size_t r = 0; r < tiles->clip.numRects; ++r) {
+      if (puglX11CairoRectsOverlap(tiles->rects[t], tiles->clip.rects[r])) {
+        tiles->queue[tiles->queueSize++] = t;
+        break;
+      }
+    }
+  }
+
+  // Wake up the workers and help them until every tile is drawn
+  cairo_surface_flush(tiles->image);
+  tiles->next    = 0;
+  tiles->numDone = 0;
+  pthread_cond_broadcast(&tiles->workCond);
+  puglX11CairoDrawQueuedTiles(view);
+  while (tiles->numDone < tiles->queueSize) {
+    pthread_cond_wait(&tiles->doneCond, &tiles->mutex);
+  }
+
+  pthread_mutex_unlock(&tiles->mutex);
+
+  // Paint the image, which replaces the damaged region
+  cairo_surface_mark_dirty(tiles->image);
+  cairo_save(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface(cr, tiles->image, 0, 0);
+  cairo_paint(cr);
+  cairo_restore(cr);
+
+  return PUGL_SUCCESS;
+}
+
+/// Stop the worker threads and free all tile state
+static void
+puglX11CairoFreeTiles(PuglX11CairoSurface* const surface)
+{
+  PuglX11CairoTiles* const tiles = surface->tiles;
+  if (!tiles) {
+    return;
+  }
+
+  pthread_mutex_lock(&tiles->mutex);
+  tiles->exiting = true;
+  pthread_cond_broadcast(&tiles->workCond);
+  pthread_mutex_unlock(&tiles->mutex);
+
+  for (unsigned i = 0; i < tiles->numThreads; ++i) {
+    pthread_join(tiles->threads[i], NULL);
+  }
+
+  puglX11CairoFreeTileSurfaces(tiles);
+  pthread_cond_destroy(&tiles->doneCond);
+  pthread_cond_destroy(&tiles->workCond);
+  pthread_mutex_destroy(&tiles->mutex);
+  free(tiles->threads);
+  free(tiles);
+  surface->tiles = NULL;
+}
+
 static void
 puglX11CairoClose(PuglView* view)
 {
@@ -43,23 +383,38 @@ puglX11CairoClose(PuglView* view)
   surface->front = surface->back = NULL;
 }
 
+/**
+   Open the surfaces for drawing if necessary.
+
+   The surfaces are kept between exposes, and only the front surface is
+   recreated (and the back resized) when the size of the view changes, so
+   drawing a frame doesn't allocate anything on the client or the server.
+*/
 static PuglStatus
 puglX11CairoOpen(PuglView* view)
 {
   PuglInternals* const       impl    = view->impl;
   PuglX11CairoSurface* const surface = (PuglX11CairoSurface*)impl->surface;
+  const int                  width   = (int)view->frame.width;
+  const int                  height  = (int)view->frame.height;
+
+  if (surface->back && surface->width == width && surface->height == height) {
+    return PUGL_SUCCESS;
+  }
 
-  surface->back = cairo_xlib_surface_create(impl->display,
-                                            impl->win,
-                                            impl->vi->visual,
-                                            (int)view->frame.width,
-                                            (int)view->frame.height);
+  if (surface->back) {
+    cairo_xlib_surface_set_size(surface->back, width, height);
+  } else {
+    surface->back = cairo_xlib_surface_create(
+      impl->display, impl->win, impl->vi->visual, width, height);
+  }
 
+  cairo_surface_destroy(surface->front);
   surface->front =
     cairo_surface_create_similar(surface->back,
                                  cairo_surface_get_content(surface->back),
-                                 (int)view->frame.width,
-                                 (int)view->frame.height);
+                                 width,
+                                 height);
 
   if (cairo_surface_status(surface->back) ||
       cairo_surface_status(surface->front)) {
@@ -67,6 +422,8 @@ puglX11CairoOpen(PuglView* view)
     return PUGL_CREATE_CONTEXT_FAILED;
   }
 
+  surface->width  = width;
+  surface->height = height;
   return PUGL_SUCCESS;
 }
 
@@ -86,6 +443,7 @@ puglX11CairoDestroy(PuglView* view)
   PuglInternals* const       impl    = view->impl;
   PuglX11CairoSurface* const surface = (PuglX11CairoSurface*)impl->surface;
 
+  puglX11CairoFreeTiles(surface);
   puglX11CairoClose(view);
   free(surface);
 
@@ -104,6 +462,14 @@ puglX11CairoEnter(PuglView* view, const PuglEventExpose* expose)
 
     if (cairo_status(surface->cr)) {
       st = PUGL_CREATE_CONTEXT_FAILED;
+    } else {
+      // Clip drawing so that only the damaged region is actually rendered
+      puglX11CairoClip(view, surface->cr, expose);
+
+      // Draw tiles first, so the application can draw over them
+      if (surface->tiles) {
+        st = puglX11CairoDrawTiles(view, surface->cr, expose);
+      }
     }
   }
 
@@ -121,25 +487,217 @@ puglX11CairoLeave(PuglView* view, const PuglEventExpose* expose)
     cairo_destroy(surface->cr);
     surface->cr = cairo_create(surface->back);
 
-    // Clip to expose region
-    cairo_rectangle(
-      surface->cr, expose->x, expose->y, expose->width, expose->height);
-    cairo_clip(surface->cr);
+    // Clip to damaged region and any region being restored
+    puglX11CairoClipPresent(view, surface->cr, expose);
 
     // Paint front onto back
     cairo_set_source_surface(surface->cr, surface->front, 0, 0);
     cairo_paint(surface->cr);
 
-    // Flush to X and close everything
+    // Flush to X, but keep the surfaces for the next expose
     cairo_destroy(surface->cr);
     cairo_surface_flush(surface->back);
-    puglX11CairoClose(view);
     surface->cr = NULL;
+    puglX11CairoUpdateRetained(view);
+  }
+
+  return PUGL_SUCCESS;
+}
+
+#ifdef HAVE_XSHM
+
+static void
+puglX11ShmClose(PuglView* view)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11CairoSurface* const surface = (PuglX11CairoSurface*)impl->surface;
+
+  if (surface->shmSurface) {
+    cairo_surface_destroy(surface->shmSurface);
+    surface->shmSurface = NULL;
+  }
+
+  if (surface->image) {
+    puglX11ShmDestroyImage(impl->display, surface->image, &surface->shmInfo);
+    surface->image      = NULL;
+    surface->putPending = false;
+  }
+
+  if (surface->gc) {
+    XFreeGC(impl->display, surface->gc);
+    surface->gc = NULL;
+  }
+}
+
+/// Create an image in a shared memory segment the size of the view
+static PuglStatus
+puglX11ShmOpen(PuglView* view)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11CairoSurface* const surface = (PuglX11CairoSurface*)impl->surface;
+  Display* const             display = impl->display;
+  const int                  width   = (int)view->frame.width;
+  const int                  height  = (int)view->frame.height;
+
+  puglX11ShmClose(view);
+
+  surface->image =
+    puglX11ShmCreateImage(display, impl->vi, width, height, &surface->shmInfo);
+
+  if (!surface->image) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  const cairo_format_t format = surface->image->depth == 32
+                                  ? CAIRO_FORMAT_ARGB32
+                                  : CAIRO_FORMAT_RGB24;
+
+  surface->gc         = XCreateGC(display, impl->win, 0, NULL);
+  surface->shmSurface = cairo_image_surface_create_for_data(
+    (unsigned char*)surface->image->data,
+    format,
+    width,
+    height,
+    surface->image->bytes_per_line);
+
+  if (!surface->gc || cairo_surface_status(surface->shmSurface)) {
+    puglX11ShmClose(view);
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+/// Put a rectangle of the image to the window, clamped to the image bounds
+static void
+puglX11ShmPutRect(PuglView* view, const PuglRect* const rect)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11CairoSurface* const surface = (PuglX11CairoSurface*)impl->surface;
+  XImage* const              image   = surface->image;
+  int                        x       = 0;
+  int                        y       = 0;
+  unsigned                   width   = 0u;
+  unsigned                   height  = 0u;
+
+  if (puglX11ImageArea(image, rect, &x, &y, &width, &height)) {
+    XShmPutImage(impl->display,
+                 impl->win,
+                 surface->gc,
+                 image,
+                 x,
+                 y,
+                 x,
+                 y,
+                 width,
+                 height,
+                 False);
+  }
+}
+
+static PuglStatus
+puglX11CairoShmCreate(PuglView* view)
+{
+  PuglInternals* const impl = view->impl;
+  const PuglStatus     st   = puglX11CairoCreate(view);
+  if (st || !impl->surface) {
+    return st ? st : PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  // Fall back to drawing via Xlib if the server doesn't support shared memory
+  PuglX11CairoSurface* const surface = (PuglX11CairoSurface*)impl->surface;
+
+  surface->shmFailed = !XShmQueryExtension(impl->display);
+  return PUGL_SUCCESS;
+}
+
+static PuglStatus
+puglX11CairoShmDestroy(PuglView* view)
+{
+  puglX11ShmClose(view);
+  return puglX11CairoDestroy(view);
+}
+
+static PuglStatus
+puglX11CairoShmEnter(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11CairoSurface* const surface = (PuglX11CairoSurface*)impl->surface;
+
+  if (!expose) {
+    return PUGL_SUCCESS;
+  }
+
+  // Recreate the image if the view has been resized
+  if (!surface->shmFailed &&
+      (!surface->image || surface->image->width != (int)view->frame.width ||
+       surface->image->height != (int)view->frame.height)) {
+    surface->shmFailed = !!puglX11ShmOpen(view);
+  }
+
+  if (surface->shmFailed) {
+    return puglX11CairoEnter(view, expose);
+  }
+
+  // Wait for the server to finish reading the previous frame
+  if (surface->putPending) {
+    XSync(impl->display, False);
+    surface->putPending = false;
+  }
+
+  surface->cr = cairo_create(surface->shmSurface);
+  if (cairo_status(surface->cr)) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  // Clip drawing so that only the damaged region is actually rendered
+  puglX11CairoClip(view, surface->cr, expose);
+
+  // Draw tiles first, so the application can draw over them
+  return surface->tiles ? puglX11CairoDrawTiles(view, surface->cr, expose)
+                        : PUGL_SUCCESS;
+}
+
+static PuglStatus
+puglX11CairoShmLeave(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11CairoSurface* const surface = (PuglX11CairoSurface*)impl->surface;
+
+  if (!expose) {
+    return PUGL_SUCCESS;
+  }
+
+  if (surface->shmFailed) {
+    return puglX11CairoLeave(view, expose);
+  }
+
+  cairo_destroy(surface->cr);
+  cairo_surface_flush(surface->shmSurface);
+  surface->cr = NULL;
+
+  // Upload only the damaged rectangles and any being restored
+  const PuglRegion* const restore = &impl->restore;
+  for (size_t i = 0; i < restore->numRects; ++i) {
+    puglX11ShmPutRect(view, &restore->rects[i]);
+  }
+
+  if (view->damage.numRects) {
+    for (size_t i = 0; i < view->damage.numRects; ++i) {
+      puglX11ShmPutRect(view, &view->damage.rects[i]);
+    }
+  } else if (!restore->numRects) {
+    const PuglRect rect = {expose->x, expose->y, expose->width, expose->height};
+    puglX11ShmPutRect(view, &rect);
   }
 
+  surface->putPending = true;
+  puglX11CairoUpdateRetained(view);
   return PUGL_SUCCESS;
 }
 
+#endif // HAVE_XSHM
+
 static void*
 puglX11CairoGetContext(PuglView* view)
 {
@@ -161,3 +719,76 @@ puglCairoBackend(void)
 
   return &backend;
 }
+
+const PuglBackend*
+puglCairoShmBackend(void)
+{
+#ifdef HAVE_XSHM
+  static const PuglBackend backend = {puglX11StubConfigure,
+                                      puglX11CairoShmCreate,
+                                      puglX11CairoShmDestroy,
+                                      puglX11CairoShmEnter,
+                                      puglX11CairoShmLeave,
+                                      puglX11CairoGetContext};
+
+  return &backend;
+#else
+  return puglCairoBackend();
+#endif
+}
+
+PuglStatus
+puglSetCairoTileFunc(PuglView* const         view,
+                     const PuglCairoTileFunc tileFunc,
+                     const unsigned          numThreads)
+{
+  if (!view->impl->win || (view->backend != puglCairoBackend() &&
+                           view->backend != puglCairoShmBackend())) {
+    return PUGL_FAILURE;
+  }
+
+  PuglX11CairoSurface* const surface =
+    (PuglX11CairoSurface*)view->impl->surface;
+
+  puglX11CairoFreeTiles(surface);
+  if (!tileFunc) {
+    return PUGL_SUCCESS;
+  }
+
+  const long     numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+  const unsigned total   = numThreads ? numThreads
+                           : numCpus > 0 ? (unsigned)numCpus
+                                         : 1u;
+
+  PuglX11CairoTiles* const tiles =
+    (PuglX11CairoTiles*)calloc(1, sizeof(PuglX11CairoTiles));
+
+  if (!tiles) {
+    return PUGL_FAILURE;
+  }
+
+  // This thread draws tiles too, so start one less worker
+  tiles->func    = tileFunc;
+  tiles->threads = (pthread_t*)calloc(total, sizeof(pthread_t));
+  pthread_mutex_init(&tiles->mutex, NULL);
+  pthread_cond_init(&tiles->workCond, NULL);
+  pthread_cond_init(&tiles->doneCond, NULL);
+  surface->tiles = tiles;
+
+  for (unsigned i = 0; tiles->threads && i + 1u < total; ++i) {
+    if (pthread_create(
+          &tiles->threads[i], NULL, puglX11CairoTileWorker, view)) {
+      break;
+    }
+
+    ++tiles->numThreads;
+  }
+
+  // Fail rather than silently drawing with fewer threads than requested
+  if (!tiles->threads || tiles->numThreads + 1u < total) {
+    puglX11CairoFreeTiles(surface);
+    return PUGL_UNKNOWN_ERROR;
+  }
+
+  return PUGL_SUCCESS;
+}
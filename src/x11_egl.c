@@ -0,0 +1,552 @@
+/*
+  Copyright 2012-2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "stub.h"
+#include "types.h"
+#include "x11.h"
+#include "x11_gl.h"
+
+#include "pugl/gl.h"
+#include "pugl/pugl.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <X11/X.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#  define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+typedef struct {
+  PuglX11GlSurfaceBase base; ///< Shared state, must be first
+  EGLConfig            config;
+  EGLContext           ctx;
+  EGLSurface           surface;
+  EGLint               width;     ///< Width of headless pbuffer surface
+  EGLint               height;    ///< Height of headless pbuffer surface
+  bool                 bufferAge; ///< True if age can be queried
+  PuglX11GlHistory     history;   ///< Damage of last frames
+
+  PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swapWithDamage; ///< Damage swap, or null
+} PuglX11EglSurface;
+
+/**
+   EGL state shared by all views in a world.
+
+   Like with GLX, the root context is created for the first view with the
+   #PUGL_SHARE_CONTEXT hint, and only exists to keep shared objects alive.
+*/
+struct PuglX11EglWorldImpl {
+  EGLDisplay display;
+  EGLContext rootCtx; ///< Context that shared contexts share with
+};
+
+static bool
+puglX11EglHasExtension(const char* const extensions, const char* const name)
+{
+  const size_t len = strlen(name);
+
+  for (const char* s = extensions; s && (s = strstr(s, name)); s += len) {
+    if ((s == extensions || s[-1] == ' ') && (!s[len] || s[len] == ' ')) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void
+puglX11EglFreeWorld(PuglX11EglWorld* const eglWorld)
+{
+  if (eglWorld->rootCtx != EGL_NO_CONTEXT) {
+    eglDestroyContext(eglWorld->display, eglWorld->rootCtx);
+  }
+
+  eglTerminate(eglWorld->display);
+  free(eglWorld);
+}
+
+/**
+   Return the EGL display for an X display, preferably with the X11 platform.
+
+   Without an X display, the Mesa surfaceless platform is used if possible,
+   which works without any display server at all.
+*/
+static EGLDisplay
+puglX11EglGetDisplay(Display* const display)
+{
+  const char* const extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+  const bool hasPlatform =
+    display ? (puglX11EglHasExtension(extensions, "EGL_KHR_platform_x11") ||
+               puglX11EglHasExtension(extensions, "EGL_EXT_platform_x11"))
+            : puglX11EglHasExtension(extensions,
+                                     "EGL_MESA_platform_surfaceless");
+
+  if (hasPlatform &&
+      puglX11EglHasExtension(extensions, "EGL_EXT_platform_base")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+        "eglGetPlatformDisplayEXT");
+
+    if (getPlatformDisplay) {
+      return display ? getPlatformDisplay(EGL_PLATFORM_X11_KHR, display, NULL)
+                     : getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                          EGL_DEFAULT_DISPLAY,
+                                          NULL);
+    }
+  }
+
+  return display ? eglGetDisplay((EGLNativeDisplayType)display)
+                 : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static PuglX11EglWorld*
+puglX11EglGetWorld(PuglWorld* const world)
+{
+  PuglWorldInternals* const impl = world->impl;
+  if (impl->eglWorld) {
+    return impl->eglWorld;
+  }
+
+  const EGLDisplay display = puglX11EglGetDisplay(impl->display);
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+    return NULL;
+  }
+
+  PuglX11EglWorld* const eglWorld =
+    (PuglX11EglWorld*)calloc(1, sizeof(PuglX11EglWorld));
+  if (!eglWorld) {
+    eglTerminate(display);
+    return NULL;
+  }
+
+  eglWorld->display  = display;
+  eglWorld->rootCtx  = EGL_NO_CONTEXT;
+  impl->eglWorld     = eglWorld;
+  impl->freeEglWorld = puglX11EglFreeWorld;
+  return eglWorld;
+}
+
+static EGLint
+puglX11EglGetAttrib(const EGLDisplay display,
+                    const EGLConfig  config,
+                    const EGLint     attrib)
+{
+  EGLint value = 0;
+  eglGetConfigAttrib(display, config, attrib, &value);
+  return value;
+}
+
+/// Return the visual for a config, or null if it can't be used on the screen
+static XVisualInfo*
+puglX11EglGetVisual(PuglView* const  view,
+                    const EGLDisplay display,
+                    const EGLConfig  config)
+{
+  PuglInternals* const impl = view->impl;
+  XVisualInfo          pat;
+  int                  n = 0;
+
+  memset(&pat, 0, sizeof(pat));
+  pat.visualid =
+    (VisualID)puglX11EglGetAttrib(display, config, EGL_NATIVE_VISUAL_ID);
+  pat.screen = impl->screen;
+
+  return pat.visualid ? XGetVisualInfo(impl->display,
+                                       VisualIDMask | VisualScreenMask,
+                                       &pat,
+                                       &n)
+                      : NULL;
+}
+
+static PuglStatus
+puglX11EglConfigure(PuglView* view)
+{
+  PuglInternals* const   impl     = view->impl;
+  PuglX11EglWorld* const eglWorld = puglX11EglGetWorld(view->world);
+
+  PuglX11EglSurface* const surface =
+    (PuglX11EglSurface*)calloc(1, sizeof(PuglX11EglSurface));
+  impl->surface = surface;
+
+  if (!eglWorld || !surface) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  // PUGL_DONT_CARE is the same as EGL_DONT_CARE, so hints can be used as is
+  // clang-format off
+  const EGLint attrs[] = {
+    EGL_SURFACE_TYPE,      impl->display ? EGL_WINDOW_BIT : EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE,   EGL_OPENGL_BIT,
+    EGL_COLOR_BUFFER_TYPE, EGL_RGB_BUFFER,
+    EGL_SAMPLES,           view->hints[PUGL_SAMPLES],
+    EGL_RED_SIZE,          view->hints[PUGL_RED_BITS],
+    EGL_GREEN_SIZE,        view->hints[PUGL_GREEN_BITS],
+    EGL_BLUE_SIZE,         view->hints[PUGL_BLUE_BITS],
+    EGL_ALPHA_SIZE,        view->hints[PUGL_ALPHA_BITS],
+    EGL_DEPTH_SIZE,        view->hints[PUGL_DEPTH_BITS],
+    EGL_STENCIL_SIZE,      view->hints[PUGL_STENCIL_BITS],
+    EGL_NONE
+  };
+  // clang-format on
+
+  const EGLDisplay display    = eglWorld->display;
+  EGLint           numConfigs = 0;
+  if (!eglChooseConfig(display, attrs, NULL, 0, &numConfigs) ||
+      numConfigs <= 0) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  EGLConfig* const configs =
+    (EGLConfig*)calloc((size_t)numConfigs, sizeof(EGLConfig));
+  if (!configs ||
+      !eglChooseConfig(display, attrs, configs, numConfigs, &numConfigs)) {
+    free(configs);
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  // Use the best config that has a visual on this screen, if there is one
+  bool found = false;
+  if (!impl->display) {
+    surface->config = configs[0];
+    found           = true;
+  }
+
+  for (EGLint i = 0; i < numConfigs && !found; ++i) {
+    if ((impl->vi = puglX11EglGetVisual(view, display, configs[i]))) {
+      surface->config = configs[i];
+      found           = true;
+    }
+  }
+
+  free(configs);
+  if (!found) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  const EGLConfig config = surface->config;
+
+  view->hints[PUGL_RED_BITS] =
+    puglX11EglGetAttrib(display, config, EGL_RED_SIZE);
+  view->hints[PUGL_GREEN_BITS] =
+    puglX11EglGetAttrib(display, config, EGL_GREEN_SIZE);
+  view->hints[PUGL_BLUE_BITS] =
+    puglX11EglGetAttrib(display, config, EGL_BLUE_SIZE);
+  view->hints[PUGL_ALPHA_BITS] =
+    puglX11EglGetAttrib(display, config, EGL_ALPHA_SIZE);
+  view->hints[PUGL_DEPTH_BITS] =
+    puglX11EglGetAttrib(display, config, EGL_DEPTH_SIZE);
+  view->hints[PUGL_STENCIL_BITS] =
+    puglX11EglGetAttrib(display, config, EGL_STENCIL_SIZE);
+  view->hints[PUGL_SAMPLES] =
+    puglX11EglGetAttrib(display, config, EGL_SAMPLES);
+
+  return PUGL_SUCCESS;
+}
+
+/// Create an offscreen surface the size of a headless view
+static EGLSurface
+puglX11EglCreatePbuffer(PuglView* const view, PuglX11EglSurface* const surface)
+{
+  const EGLDisplay display = view->world->impl->eglWorld->display;
+
+  surface->width  = (EGLint)view->frame.width;
+  surface->height = (EGLint)view->frame.height;
+
+  const EGLint attrs[] = {
+    EGL_WIDTH, surface->width, EGL_HEIGHT, surface->height, EGL_NONE};
+
+  return eglCreatePbufferSurface(display, surface->config, attrs);
+}
+
+static PuglStatus
+puglX11EglEnter(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglX11EglSurface* const surface = (PuglX11EglSurface*)view->impl->surface;
+  const EGLDisplay         display = view->world->impl->eglWorld->display;
+
+  // A pbuffer has a fixed size, so replace it if a headless view was resized
+  if (!view->impl->display && (surface->width != (EGLint)view->frame.width ||
+                               surface->height != (EGLint)view->frame.height)) {
+    const EGLSurface oldSurface = surface->surface;
+    if (eglGetCurrentSurface(EGL_DRAW) == oldSurface) {
+      eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    eglDestroySurface(display, oldSurface);
+    surface->surface = puglX11EglCreatePbuffer(view, surface);
+    if (surface->surface == EGL_NO_SURFACE) {
+      return PUGL_CREATE_CONTEXT_FAILED;
+    }
+  }
+
+  // Switching contexts is expensive, so skip it if this one is still current
+  if (eglGetCurrentContext() != surface->ctx ||
+      eglGetCurrentSurface(EGL_DRAW) != surface->surface) {
+    eglMakeCurrent(display, surface->surface, surface->surface, surface->ctx);
+  }
+
+  if (expose && puglX11GlIsPartial(view)) {
+    // Clip drawing to the damage, and anything the back buffer is missing
+    EGLint age = 0;
+    if (surface->bufferAge) {
+      eglQuerySurface(display, surface->surface, EGL_BUFFER_AGE_EXT, &age);
+    }
+
+    puglX11GlClipDamage(
+      view, expose, &surface->history, age > 0 ? (unsigned)age : 0u);
+  }
+
+  return PUGL_SUCCESS;
+}
+
+/// Swap buffers, telling the server which region changed if possible
+static void
+puglX11EglSwapDamage(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglX11EglSurface* const surface = (PuglX11EglSurface*)view->impl->surface;
+  const EGLDisplay         display = view->world->impl->eglWorld->display;
+  const PuglRegion* const  damage  = &view->damage;
+
+  puglX11GlEndDamage(&surface->history);
+
+  if (!surface->swapWithDamage) {
+    eglSwapBuffers(display, surface->surface);
+    return;
+  }
+
+  const PuglRect exposed = {
+    expose->x, expose->y, expose->width, expose->height};
+
+  // Rectangles have their origin at the bottom left like in OpenGL
+  const PuglRect* const rects    = damage->numRects ? damage->rects : &exposed;
+  const size_t          numRects = damage->numRects ? damage->numRects : 1u;
+  EGLint                coords[4u * PUGL_MAX_REGION_RECTS];
+  for (size_t i = 0u; i < numRects; ++i) {
+    const PuglRect* const r = &rects[i];
+
+    coords[4u * i]      = (EGLint)r->x;
+    coords[4u * i + 1u] = (EGLint)(view->frame.height - r->y - r->height);
+    coords[4u * i + 2u] = (EGLint)r->width;
+    coords[4u * i + 3u] = (EGLint)r->height;
+  }
+
+  surface->swapWithDamage(display, surface->surface, coords, (EGLint)numRects);
+}
+
+static PuglStatus
+puglX11EglLeave(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglX11EglSurface* const surface = (PuglX11EglSurface*)view->impl->surface;
+  const EGLDisplay         display = view->world->impl->eglWorld->display;
+
+  if (expose) {
+    puglX11GlCaptureFrame(view);
+    puglX11GlBeginPresent(view);
+  }
+
+  if (expose && puglX11GlIsPartial(view)) {
+    puglX11EglSwapDamage(view, expose);
+  } else if (expose && view->hints[PUGL_DOUBLE_BUFFER]) {
+    eglSwapBuffers(display, surface->surface);
+  }
+
+  if (expose) {
+    puglX11GlRecordPresent(view, false);
+  }
+
+  if (!view->hints[PUGL_STICKY_CONTEXT]) {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static PuglStatus
+puglX11EglCreate(PuglView* view)
+{
+  PuglInternals* const     impl     = view->impl;
+  PuglX11EglSurface* const surface  = (PuglX11EglSurface*)impl->surface;
+  PuglX11EglWorld* const   eglWorld = view->world->impl->eglWorld;
+  const EGLDisplay         display  = eglWorld->display;
+  const EGLConfig          config   = surface->config;
+
+  const EGLint surfaceAttrs[] = {EGL_RENDER_BUFFER,
+                                 view->hints[PUGL_DOUBLE_BUFFER] == PUGL_FALSE
+                                   ? EGL_SINGLE_BUFFER
+                                   : EGL_BACK_BUFFER,
+                                 EGL_NONE};
+
+  if (impl->display) {
+    surface->surface = eglCreateWindowSurface(
+      display, config, (EGLNativeWindowType)impl->win, surfaceAttrs);
+  } else {
+    surface->surface = puglX11EglCreatePbuffer(view, surface);
+  }
+
+  if (surface->surface == EGL_NO_SURFACE) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  // Use extensions for drawing and presenting only damage if available
+  const char* const extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (impl->display) {
+    surface->bufferAge =
+      puglX11EglHasExtension(extensions, "EGL_EXT_buffer_age");
+
+    if (puglX11EglHasExtension(extensions,
+                               "EGL_KHR_swap_buffers_with_damage")) {
+      surface->swapWithDamage =
+        (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress(
+          "eglSwapBuffersWithDamageKHR");
+    } else if (puglX11EglHasExtension(extensions,
+                                      "EGL_EXT_swap_buffers_with_damage")) {
+      surface->swapWithDamage =
+        (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress(
+          "eglSwapBuffersWithDamageEXT");
+    }
+  }
+
+  const EGLint ctxAttrs[] = {
+    EGL_CONTEXT_MAJOR_VERSION_KHR,
+    view->hints[PUGL_CONTEXT_VERSION_MAJOR],
+
+    EGL_CONTEXT_MINOR_VERSION_KHR,
+    view->hints[PUGL_CONTEXT_VERSION_MINOR],
+
+    EGL_CONTEXT_FLAGS_KHR,
+    (view->hints[PUGL_USE_DEBUG_CONTEXT] ? EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR
+                                         : 0),
+
+    EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR,
+    (view->hints[PUGL_USE_COMPAT_PROFILE]
+       ? EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR
+       : EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR),
+
+    EGL_NONE};
+
+  eglBindAPI(EGL_OPENGL_API);
+
+  if (view->hints[PUGL_STICKY_CONTEXT] != PUGL_TRUE) {
+    view->hints[PUGL_STICKY_CONTEXT] = PUGL_FALSE;
+  }
+
+  // Share with the world if requested, or fall back to a separate context
+  surface->ctx = EGL_NO_CONTEXT;
+  if (view->hints[PUGL_SHARE_CONTEXT] == PUGL_TRUE) {
+    if (eglWorld->rootCtx == EGL_NO_CONTEXT) {
+      eglWorld->rootCtx =
+        eglCreateContext(display, config, EGL_NO_CONTEXT, ctxAttrs);
+    }
+
+    if (eglWorld->rootCtx != EGL_NO_CONTEXT) {
+      surface->ctx =
+        eglCreateContext(display, config, eglWorld->rootCtx, ctxAttrs);
+    }
+  }
+
+  view->hints[PUGL_SHARE_CONTEXT] =
+    surface->ctx != EGL_NO_CONTEXT ? PUGL_TRUE : PUGL_FALSE;
+
+  if (surface->ctx == EGL_NO_CONTEXT) {
+    surface->ctx = eglCreateContext(display, config, EGL_NO_CONTEXT, ctxAttrs);
+  }
+
+  if (surface->ctx == EGL_NO_CONTEXT) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  // Set the swap interval, which is 1 by default and can't be queried
+  const int swapInterval = view->hints[PUGL_SWAP_INTERVAL];
+  if (!impl->display) {
+    // Nothing is presented, but statistics use any requested interval
+    if (swapInterval == PUGL_DONT_CARE) {
+      view->hints[PUGL_SWAP_INTERVAL] = 0;
+    }
+  } else if (swapInterval != PUGL_DONT_CARE) {
+    puglX11EglEnter(view, NULL);
+    eglSwapInterval(display, swapInterval);
+    puglX11EglLeave(view, NULL);
+  } else {
+    view->hints[PUGL_SWAP_INTERVAL] = 1;
+  }
+
+  // EGL can't say when frames are shown, so statistics always use the clock
+  puglX11GlInitPresent(view);
+
+  EGLint renderBuffer = EGL_BACK_BUFFER;
+  eglQuerySurface(display, surface->surface, EGL_RENDER_BUFFER, &renderBuffer);
+  view->hints[PUGL_DOUBLE_BUFFER] =
+    (impl->display && renderBuffer == EGL_BACK_BUFFER) ? PUGL_TRUE : PUGL_FALSE;
+
+  return PUGL_SUCCESS;
+}
+
+static PuglStatus
+puglX11EglDestroy(PuglView* view)
+{
+  PuglX11EglSurface* const surface  = (PuglX11EglSurface*)view->impl->surface;
+  PuglX11EglWorld* const   eglWorld = view->world->impl->eglWorld;
+
+  if (surface) {
+    if (eglWorld) {
+      const EGLDisplay display = eglWorld->display;
+
+      puglX11GlEndCapture(view, false);
+      puglX11GlFreePresent(view);
+
+      // A sticky context may still be current, which would keep it alive
+      if (surface->ctx != EGL_NO_CONTEXT &&
+          eglGetCurrentContext() == surface->ctx) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      }
+
+      if (surface->ctx != EGL_NO_CONTEXT) {
+        eglDestroyContext(display, surface->ctx);
+      }
+
+      if (surface->surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface->surface);
+      }
+    }
+
+    free(surface);
+    view->impl->surface = NULL;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+const PuglBackend*
+puglEglBackend(void)
+{
+  static const PuglBackend backend = {puglX11EglConfigure,
+                                      puglX11EglCreate,
+                                      puglX11EglDestroy,
+                                      puglX11EglEnter,
+                                      puglX11EglLeave,
+                                      puglStubGetContext};
+
+  return &backend;
+}
@@ -17,23 +17,160 @@
 #include "stub.h"
 #include "types.h"
 #include "x11.h"
+#include "x11_gl.h"
 
 #include "pugl/gl.h"
 #include "pugl/pugl.h"
 
+#include <GL/gl.h>
+#include <GL/glext.h>
 #include <GL/glx.h>
 #include <X11/X.h>
 #include <X11/Xlib.h>
 
+#ifdef HAVE_EGL
+#  include <EGL/egl.h>
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifndef MIN
+#  define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#  define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#ifndef GLX_BACK_BUFFER_AGE_EXT
+#  define GLX_BACK_BUFFER_AGE_EXT 0x20F4
+#endif
+
+/// Number of frames that can be copied at once before capture must wait
+#define PUGL_GL_CAPTURE_FRAMES 3u
+
+/// Time to wait for a captured frame to be copied before dropping it in ns
+#define PUGL_GL_CAPTURE_TIMEOUT 1000000000u
 
 typedef struct {
-  GLXFBConfig fb_config;
-  GLXContext  ctx;
+  PuglX11GlSurfaceBase        base; ///< Shared state, must be first
+  GLXFBConfig                 fb_config;
+  GLXContext                  ctx;
+  PFNGLXCOPYSUBBUFFERMESAPROC copySubBuffer; ///< Partial present, or null
+  bool                        bufferAge;     ///< True if age can be queried
+  PuglX11GlHistory            history;       ///< Damage of last frames
 } PuglX11GlSurface;
 
+typedef struct {
+  GLuint      buffer; ///< Pixel buffer object the frame is copied to
+  GLsync      fence;  ///< Fence for the end of the copy
+  size_t      size;   ///< Allocated size of buffer in bytes
+  PuglGlFrame frame;  ///< Description of the frame, without pixels
+} PuglX11GlCaptureSlot;
+
+/**
+   Asynchronous frame capture.
+
+   Frames are copied into a ring of pixel buffer objects, and a fence is
+   inserted after each copy so that finished frames can be found without
+   waiting.  The frames being copied are the ones from `head` to `head +
+   count`, modulo the number of slots.
+*/
+struct PuglX11GlCaptureImpl {
+  PuglGlCaptureFunc       func;
+  PFNGLGENBUFFERSPROC     genBuffers;
+  PFNGLDELETEBUFFERSPROC  deleteBuffers;
+  PFNGLBINDBUFFERPROC     bindBuffer;
+  PFNGLBUFFERDATAPROC     bufferData;
+  PFNGLMAPBUFFERRANGEPROC mapBufferRange;
+  PFNGLUNMAPBUFFERPROC    unmapBuffer;
+  PFNGLFENCESYNCPROC      fenceSync;
+  PFNGLCLIENTWAITSYNCPROC clientWaitSync;
+  PFNGLDELETESYNCPROC     deleteSync;
+  PuglX11GlCaptureSlot    slots[PUGL_GL_CAPTURE_FRAMES];
+  size_t                  head;  ///< Index of the oldest frame being copied
+  size_t                  count; ///< Number of frames being copied
+};
+
+/**
+   Presentation statistics.
+
+   With GLX_OML_sync_control, the swap count and retrace count of the latest
+   swap that has been shown are used to find which frames were presented
+   since the last, and when.  Otherwise, the clock is used.
+
+   Missed retraces are counted from when a swap was issued, so time spent
+   idle between frames isn't counted as missed.
+*/
+struct PuglX11GlPresentImpl {
+  PuglGlFrameStats           stats;
+  PFNGLXGETSYNCVALUESOMLPROC getSyncValues; ///< OML query, or null
+  PFNGLXWAITFORSBCOMLPROC    waitForSbc;    ///< OML swap wait, or null
+  double                     swapTime;      ///< Time the last swap was issued
+  int64_t                    swapMsc;       ///< Retrace count at next swap
+  int64_t                    issuedSbc;     ///< Swap count of the last swap
+};
+
+static bool
+puglX11GlHasExtension(const char* const extensions, const char* const name)
+{
+  const size_t len = strlen(name);
+
+  for (const char* s = extensions; s && (s = strstr(s, name)); s += len) {
+    if ((s == extensions || s[-1] == ' ') && (!s[len] || s[len] == ' ')) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/// Return the bounding box of two rectangles
+static PuglRect
+puglX11GlUnionRect(const PuglRect a, const PuglRect b)
+{
+  const double   maxX   = MAX(a.x + a.width, b.x + b.width);
+  const double   maxY   = MAX(a.y + a.height, b.y + b.height);
+  const PuglRect bounds = {MIN(a.x, b.x),
+                           MIN(a.y, b.y),
+                           maxX - MIN(a.x, b.x),
+                           maxY - MIN(a.y, b.y)};
+
+  return bounds;
+}
+
+/// Return the bounding box of the damaged region, or the expose if none
+static PuglRect
+puglX11GlDamageBounds(const PuglView* const view, const PuglEventExpose* expose)
+{
+  if (!view->damage.numRects) {
+    const PuglRect rect = {expose->x, expose->y, expose->width, expose->height};
+    return rect;
+  }
+
+  PuglRect bounds = view->damage.rects[0];
+  for (size_t i = 1u; i < view->damage.numRects; ++i) {
+    bounds = puglX11GlUnionRect(bounds, view->damage.rects[i]);
+  }
+
+  return bounds;
+}
+
+/// Replace the damaged region with the whole view
+static void
+puglX11GlDamageAll(PuglView* const view)
+{
+  const PuglRect all = {0.0, 0.0, view->frame.width, view->frame.height};
+
+  view->damage.rects[0] = all;
+  view->damage.numRects = 1u;
+}
+
 static int
 puglX11GlHintValue(const int value)
 {
@@ -50,85 +187,460 @@ puglX11GlGetAttrib(Display* const display,
   return value;
 }
 
-static PuglStatus
-puglX11GlConfigure(PuglView* view)
+/// Hints that affect the choice of framebuffer configuration
+static const struct {
+  PuglViewHint hint;
+  int          attrib;
+} puglX11GlConfigHints[] = {
+  {PUGL_SAMPLES, GLX_SAMPLES},
+  {PUGL_RED_BITS, GLX_RED_SIZE},
+  {PUGL_GREEN_BITS, GLX_GREEN_SIZE},
+  {PUGL_BLUE_BITS, GLX_BLUE_SIZE},
+  {PUGL_ALPHA_BITS, GLX_ALPHA_SIZE},
+  {PUGL_DEPTH_BITS, GLX_DEPTH_SIZE},
+  {PUGL_STENCIL_BITS, GLX_STENCIL_SIZE},
+  {PUGL_DOUBLE_BUFFER, GLX_DOUBLEBUFFER},
+};
+
+#define PUGL_NUM_GL_CONFIG_HINTS \
+  (sizeof(puglX11GlConfigHints) / sizeof(puglX11GlConfigHints[0]))
+
+/// Framebuffer configurations chosen for a screen and set of hints
+typedef struct {
+  int          screen;
+  int          hints[PUGL_NUM_GL_CONFIG_HINTS];  ///< Requested values
+  int          actual[PUGL_NUM_GL_CONFIG_HINTS]; ///< Values of configs[0]
+  GLXFBConfig* configs;                          ///< Ranked configurations
+  int          numConfigs;
+} PuglX11GlConfigs;
+
+/**
+   OpenGL state shared by all views in a world.
+
+   Choosing a configuration and querying its attributes is slow with some
+   drivers, and hosts often create many views with the same hints, so the
+   results are cached here for the lifetime of the world.
+
+   The root context is created for the first view with the
+   #PUGL_SHARE_CONTEXT hint, and is never made current.  It only exists so
+   that shared objects outlive the views that created them.
+*/
+struct PuglX11GlWorldImpl {
+  Display*          display;
+  PuglX11GlConfigs* configs;
+  size_t            numConfigs;
+  GLXContext        rootCtx; ///< Context that shared contexts share with
+};
+
+static bool puglX11GlShareError = false;
+
+static int
+puglX11GlShareErrorHandler(Display* const display, XErrorEvent* const event)
 {
-  PuglInternals* const impl    = view->impl;
-  const int            screen  = impl->screen;
-  Display* const       display = impl->display;
+  (void)display;
+  (void)event;
 
-  PuglX11GlSurface* const surface =
-    (PuglX11GlSurface*)calloc(1, sizeof(PuglX11GlSurface));
-  impl->surface = surface;
+  puglX11GlShareError = true;
+  return 0;
+}
+
+static void
+puglX11GlFreeWorld(PuglX11GlWorld* const glWorld)
+{
+  if (glWorld->rootCtx) {
+    glXDestroyContext(glWorld->display, glWorld->rootCtx);
+  }
+
+  for (size_t i = 0u; i < glWorld->numConfigs; ++i) {
+    XFree(glWorld->configs[i].configs);
+  }
+
+  free(glWorld->configs);
+  free(glWorld);
+}
+
+static PuglX11GlWorld*
+puglX11GlGetWorld(PuglWorld* const world)
+{
+  PuglWorldInternals* const impl = world->impl;
+
+  if (!impl->glWorld &&
+      (impl->glWorld = (PuglX11GlWorld*)calloc(1, sizeof(PuglX11GlWorld)))) {
+    impl->glWorld->display = impl->display;
+    impl->freeGlWorld      = puglX11GlFreeWorld;
+  }
+
+  return impl->glWorld;
+}
+
+static PuglX11GlConfigs*
+puglX11GlFindConfigs(const PuglX11GlWorld* const glWorld,
+                     const int                   screen,
+                     const int* const            hints)
+{
+  for (size_t i = 0u; i < glWorld->numConfigs; ++i) {
+    PuglX11GlConfigs* const entry = &glWorld->configs[i];
+
+    if (entry->screen == screen &&
+        !memcmp(entry->hints, hints, sizeof(entry->hints))) {
+      return entry;
+    }
+  }
 
+  return NULL;
+}
+
+static PuglX11GlConfigs*
+puglX11GlChooseConfigs(PuglX11GlWorld* const glWorld,
+                       Display* const        display,
+                       const int             screen,
+                       const int* const      hints)
+{
   // clang-format off
-  const int attrs[] = {
+  int attrs[8u + (2u * PUGL_NUM_GL_CONFIG_HINTS) + 1u] = {
     GLX_X_RENDERABLE,  True,
     GLX_X_VISUAL_TYPE, GLX_TRUE_COLOR,
     GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
     GLX_RENDER_TYPE,   GLX_RGBA_BIT,
-    GLX_SAMPLES,       puglX11GlHintValue(view->hints[PUGL_SAMPLES]),
-    GLX_RED_SIZE,      puglX11GlHintValue(view->hints[PUGL_RED_BITS]),
-    GLX_GREEN_SIZE,    puglX11GlHintValue(view->hints[PUGL_GREEN_BITS]),
-    GLX_BLUE_SIZE,     puglX11GlHintValue(view->hints[PUGL_BLUE_BITS]),
-    GLX_ALPHA_SIZE,    puglX11GlHintValue(view->hints[PUGL_ALPHA_BITS]),
-    GLX_DEPTH_SIZE,    puglX11GlHintValue(view->hints[PUGL_DEPTH_BITS]),
-    GLX_STENCIL_SIZE,  puglX11GlHintValue(view->hints[PUGL_STENCIL_BITS]),
-    GLX_DOUBLEBUFFER,  puglX11GlHintValue(view->hints[PUGL_DOUBLE_BUFFER]),
-    None
   };
   // clang-format on
 
+  size_t n_attrs = 8u;
+  for (size_t i = 0u; i < PUGL_NUM_GL_CONFIG_HINTS; ++i) {
+    attrs[n_attrs++] = puglX11GlConfigHints[i].attrib;
+    attrs[n_attrs++] = puglX11GlHintValue(hints[i]);
+  }
+  attrs[n_attrs] = None;
+
   int          n_fbc = 0;
   GLXFBConfig* fbc   = glXChooseFBConfig(display, screen, attrs, &n_fbc);
-  if (n_fbc <= 0) {
+  if (!fbc || n_fbc <= 0) {
+    if (fbc) {
+      XFree(fbc);
+    }
+
+    return NULL;
+  }
+
+  PuglX11GlConfigs* const configs = (PuglX11GlConfigs*)realloc(
+    glWorld->configs, (glWorld->numConfigs + 1u) * sizeof(PuglX11GlConfigs));
+  if (!configs) {
+    XFree(fbc);
+    return NULL;
+  }
+
+  PuglX11GlConfigs* const entry = &configs[glWorld->numConfigs];
+
+  glWorld->configs = configs;
+  ++glWorld->numConfigs;
+
+  entry->screen     = screen;
+  entry->configs    = fbc;
+  entry->numConfigs = n_fbc;
+  for (size_t i = 0u; i < PUGL_NUM_GL_CONFIG_HINTS; ++i) {
+    entry->hints[i]  = hints[i];
+    entry->actual[i] =
+      puglX11GlGetAttrib(display, fbc[0], puglX11GlConfigHints[i].attrib);
+  }
+
+  return entry;
+}
+
+static PuglStatus
+puglX11GlConfigure(PuglView* view)
+{
+  PuglInternals* const impl    = view->impl;
+  const int            screen  = impl->screen;
+  Display* const       display = impl->display;
+
+  if (!display) {
+    return PUGL_BACKEND_FAILED; // GLX needs an X server, use EGL for headless
+  }
+
+  PuglX11GlWorld* const glWorld = puglX11GlGetWorld(view->world);
+
+  PuglX11GlSurface* const surface =
+    (PuglX11GlSurface*)calloc(1, sizeof(PuglX11GlSurface));
+  impl->surface = surface;
+
+  if (!glWorld || !surface) {
     return PUGL_CREATE_CONTEXT_FAILED;
   }
 
-  surface->fb_config = fbc[0];
-  impl->vi           = glXGetVisualFromFBConfig(impl->display, fbc[0]);
+  // Use the configurations chosen for a previous view with the same hints
+  int hints[PUGL_NUM_GL_CONFIG_HINTS];
+  for (size_t i = 0u; i < PUGL_NUM_GL_CONFIG_HINTS; ++i) {
+    hints[i] = view->hints[puglX11GlConfigHints[i].hint];
+  }
 
-  view->hints[PUGL_RED_BITS] =
-    puglX11GlGetAttrib(display, fbc[0], GLX_RED_SIZE);
-  view->hints[PUGL_GREEN_BITS] =
-    puglX11GlGetAttrib(display, fbc[0], GLX_GREEN_SIZE);
-  view->hints[PUGL_BLUE_BITS] =
-    puglX11GlGetAttrib(display, fbc[0], GLX_BLUE_SIZE);
-  view->hints[PUGL_ALPHA_BITS] =
-    puglX11GlGetAttrib(display, fbc[0], GLX_ALPHA_SIZE);
-  view->hints[PUGL_DEPTH_BITS] =
-    puglX11GlGetAttrib(display, fbc[0], GLX_DEPTH_SIZE);
-  view->hints[PUGL_STENCIL_BITS] =
-    puglX11GlGetAttrib(display, fbc[0], GLX_STENCIL_SIZE);
-  view->hints[PUGL_SAMPLES] = puglX11GlGetAttrib(display, fbc[0], GLX_SAMPLES);
-  view->hints[PUGL_DOUBLE_BUFFER] =
-    puglX11GlGetAttrib(display, fbc[0], GLX_DOUBLEBUFFER);
+  PuglX11GlConfigs* entry = puglX11GlFindConfigs(glWorld, screen, hints);
+  if (!entry &&
+      !(entry = puglX11GlChooseConfigs(glWorld, display, screen, hints))) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  surface->fb_config = entry->configs[0];
+  impl->vi = glXGetVisualFromFBConfig(impl->display, entry->configs[0]);
 
-  XFree(fbc);
+  for (size_t i = 0u; i < PUGL_NUM_GL_CONFIG_HINTS; ++i) {
+    view->hints[puglX11GlConfigHints[i].hint] = entry->actual[i];
+  }
 
   return PUGL_SUCCESS;
 }
 
+bool
+puglX11GlIsPartial(const PuglView* const view)
+{
+  return view->hints[PUGL_RETAIN_CONTENTS] == PUGL_TRUE &&
+         view->hints[PUGL_DOUBLE_BUFFER] == PUGL_TRUE;
+}
+
+/**
+   Clip drawing to the damage that must be drawn to the back buffer.
+
+   The back buffer holds the frame that was presented `age` frames ago, where
+   1 is the last frame, and 0 means the age isn't known.  Everything damaged
+   since then is added to the damaged region, or the whole view if the age is
+   unknown or older than the history.  Nothing is clipped if only a region
+   that was kept is being restored.
+*/
+void
+puglX11GlClipDamage(PuglView* const              view,
+                    const PuglEventExpose* const expose,
+                    PuglX11GlHistory* const      history,
+                    const unsigned               age)
+{
+  if (!view->damage.numRects && view->impl->restore.numRects) {
+    return;
+  }
+
+  history->frame = puglX11GlDamageBounds(view, expose);
+
+  if (!age || age - 1u > history->numRects) {
+    puglX11GlDamageAll(view);
+  } else if (age > 1u) {
+    // Collapse damage to a single box so older frames can be added to it
+    PuglRect bounds = history->frame;
+    for (unsigned i = 0u; i + 1u < age; ++i) {
+      bounds = puglX11GlUnionRect(bounds, history->rects[i]);
+    }
+
+    view->damage.rects[0] = bounds;
+    view->damage.numRects = 1u;
+  }
+
+  const PuglRect bounds = puglX11GlDamageBounds(view, expose);
+  glEnable(GL_SCISSOR_TEST);
+  glScissor((GLint)bounds.x,
+            (GLint)(view->frame.height - bounds.y - bounds.height),
+            (GLsizei)bounds.width,
+            (GLsizei)bounds.height);
+
+  history->clipped = true;
+}
+
+void
+puglX11GlEndDamage(PuglX11GlHistory* const history)
+{
+  glDisable(GL_SCISSOR_TEST);
+
+  if (history->clipped) {
+    memmove(history->rects + 1,
+            history->rects,
+            (PUGL_GL_MAX_BUFFER_AGE - 1u) * sizeof(PuglRect));
+
+    history->rects[0] = history->frame;
+    history->numRects = MIN(history->numRects + 1u, PUGL_GL_MAX_BUFFER_AGE);
+    history->clipped  = false;
+  }
+}
+
+/// Return the age of the back buffer, or zero if it isn't known
+static unsigned
+puglX11GlGetBufferAge(const PuglView* const view)
+{
+  PuglInternals* const          impl    = view->impl;
+  const PuglX11GlSurface* const surface = (PuglX11GlSurface*)impl->surface;
+
+  // With partial copies, the back buffer always holds the last frame
+  if (surface->copySubBuffer) {
+    return 1u;
+  }
+
+  unsigned age = 0u;
+  if (surface->bufferAge) {
+    glXQueryDrawable(impl->display, impl->win, GLX_BACK_BUFFER_AGE_EXT, &age);
+  }
+
+  return age;
+}
+
+/// Copy a rectangle of the back buffer to the window
+static void
+puglX11GlCopyRect(PuglView* const view, const PuglRect* const rect)
+{
+  PuglX11GlSurface* const surface = (PuglX11GlSurface*)view->impl->surface;
+
+  const int x = (int)rect->x;
+  const int y = (int)(view->frame.height - rect->y - rect->height);
+
+  surface->copySubBuffer(view->impl->display,
+                         view->impl->win,
+                         x,
+                         y,
+                         (int)rect->width,
+                         (int)rect->height);
+}
+
 static PuglStatus
-puglX11GlEnter(PuglView* view, const PuglEventExpose* PUGL_UNUSED(expose))
+puglX11GlEnter(PuglView* view, const PuglEventExpose* expose)
 {
   PuglX11GlSurface* surface = (PuglX11GlSurface*)view->impl->surface;
-  glXMakeCurrent(view->impl->display, view->impl->win, surface->ctx);
+
+  // Switching contexts is expensive, so skip it if this one is still current
+  if (glXGetCurrentContext() != surface->ctx ||
+      glXGetCurrentDrawable() != view->impl->win) {
+    glXMakeCurrent(view->impl->display, view->impl->win, surface->ctx);
+  }
+
+  if (expose && puglX11GlIsPartial(view)) {
+    // Clip drawing to the region that needs to be drawn
+    puglX11GlClipDamage(
+      view, expose, &surface->history, puglX11GlGetBufferAge(view));
+  }
+
   return PUGL_SUCCESS;
 }
 
+/// Present the damaged region and any region being restored
+static void
+puglX11GlPresentPartial(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglInternals* const    impl    = view->impl;
+  PuglX11GlSurface* const surface = (PuglX11GlSurface*)impl->surface;
+  const PuglRegion* const restore = &impl->restore;
+
+  puglX11GlEndDamage(&surface->history);
+
+  if (!surface->copySubBuffer) {
+    glXSwapBuffers(impl->display, impl->win);
+    return;
+  }
+
+  // Copy only the damaged and restored rectangles, which flushes implicitly
+  for (size_t i = 0; i < restore->numRects; ++i) {
+    puglX11GlCopyRect(view, &restore->rects[i]);
+  }
+
+  for (size_t i = 0; i < view->damage.numRects; ++i) {
+    const PuglRect* const r = &view->damage.rects[i];
+
+    puglX11GlCopyRect(view, r);
+    if (r->x <= 0.0 && r->y <= 0.0 && r->x + r->width >= view->frame.width &&
+        r->y + r->height >= view->frame.height) {
+      impl->retained = true;
+    }
+  }
+
+  if (!view->damage.numRects && !restore->numRects) {
+    const PuglRect rect = {expose->x, expose->y, expose->width, expose->height};
+    puglX11GlCopyRect(view, &rect);
+  }
+}
+
 static PuglStatus
 puglX11GlLeave(PuglView* view, const PuglEventExpose* expose)
 {
-  if (expose && view->hints[PUGL_DOUBLE_BUFFER]) {
+  PuglX11GlSurface* const surface = (PuglX11GlSurface*)view->impl->surface;
+
+  if (expose) {
+    puglX11GlCaptureFrame(view);
+    puglX11GlBeginPresent(view);
+  }
+
+  if (expose && puglX11GlIsPartial(view)) {
+    puglX11GlPresentPartial(view, expose);
+  } else if (expose && view->hints[PUGL_DOUBLE_BUFFER]) {
     glXSwapBuffers(view->impl->display, view->impl->win);
   }
 
-  glXMakeCurrent(view->impl->display, None, NULL);
+  if (expose) {
+    // Partial copies aren't swaps, so the display can't say when they're shown
+    puglX11GlRecordPresent(view,
+                           view->hints[PUGL_DOUBLE_BUFFER] &&
+                             !(puglX11GlIsPartial(view) &&
+                               surface->copySubBuffer));
+  }
+
+  if (!view->hints[PUGL_STICKY_CONTEXT]) {
+    glXMakeCurrent(view->impl->display, None, NULL);
+  }
 
   return PUGL_SUCCESS;
 }
 
+static GLXContext
+puglX11GlCreateContext(Display* const   display,
+                       GLXFBConfig      fb_config,
+                       GLXContext       share,
+                       const int* const ctx_attrs)
+{
+  PFNGLXCREATECONTEXTATTRIBSARBPROC create_context =
+    (PFNGLXCREATECONTEXTATTRIBSARBPROC)glXGetProcAddress(
+      (const uint8_t*)"glXCreateContextAttribsARB");
+
+  GLXContext ctx = create_context(display, fb_config, share, True, ctx_attrs);
+  if (!ctx) {
+    ctx = glXCreateNewContext(display, fb_config, GLX_RGBA_TYPE, share, True);
+  }
+
+  return ctx;
+}
+
+/**
+   Create a context that shares objects with the root context of the world.
+
+   The root context is created first if necessary.  Contexts can only share
+   if they are compatible, which the server checks, so errors are caught here
+   rather than being fatal, and null is returned if sharing isn't possible.
+*/
+static GLXContext
+puglX11GlCreateSharedContext(PuglView* const  view,
+                             GLXFBConfig      fb_config,
+                             const int* const ctx_attrs)
+{
+  Display* const        display = view->impl->display;
+  PuglX11GlWorld* const glWorld = view->world->impl->glWorld;
+  GLXContext            ctx     = NULL;
+
+  XSync(display, False);
+  int (*const oldHandler)(Display*, XErrorEvent*) =
+    XSetErrorHandler(puglX11GlShareErrorHandler);
+
+  puglX11GlShareError = false;
+  if (!glWorld->rootCtx) {
+    glWorld->rootCtx =
+      puglX11GlCreateContext(display, fb_config, NULL, ctx_attrs);
+    XSync(display, False);
+  }
+
+  if (glWorld->rootCtx && !puglX11GlShareError) {
+    ctx =
+      puglX11GlCreateContext(display, fb_config, glWorld->rootCtx, ctx_attrs);
+    XSync(display, False);
+  }
+
+  XSetErrorHandler(oldHandler);
+
+  if (ctx && puglX11GlShareError) {
+    glXDestroyContext(display, ctx);
+    ctx = NULL;
+  }
+
+  return ctx;
+}
+
 static PuglStatus
 puglX11GlCreate(PuglView* view)
 {
@@ -153,24 +665,50 @@ puglX11GlCreate(PuglView* view)
        : GLX_CONTEXT_CORE_PROFILE_BIT_ARB),
     0};
 
-  PFNGLXCREATECONTEXTATTRIBSARBPROC create_context =
-    (PFNGLXCREATECONTEXTATTRIBSARBPROC)glXGetProcAddress(
-      (const uint8_t*)"glXCreateContextAttribsARB");
-
   PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT =
     (PFNGLXSWAPINTERVALEXTPROC)glXGetProcAddress(
       (const uint8_t*)"glXSwapIntervalEXT");
 
-  surface->ctx = create_context(display, fb_config, 0, True, ctx_attrs);
+  if (view->hints[PUGL_STICKY_CONTEXT] != PUGL_TRUE) {
+    view->hints[PUGL_STICKY_CONTEXT] = PUGL_FALSE;
+  }
+
+  // Share with the world if requested, or fall back to a separate context
+  if (view->hints[PUGL_SHARE_CONTEXT] == PUGL_TRUE) {
+    surface->ctx = puglX11GlCreateSharedContext(view, fb_config, ctx_attrs);
+  }
+
+  view->hints[PUGL_SHARE_CONTEXT] = surface->ctx ? PUGL_TRUE : PUGL_FALSE;
   if (!surface->ctx) {
-    surface->ctx =
-      glXCreateNewContext(display, fb_config, GLX_RGBA_TYPE, 0, True);
+    surface->ctx = puglX11GlCreateContext(display, fb_config, NULL, ctx_attrs);
   }
 
   if (!surface->ctx) {
     return PUGL_CREATE_CONTEXT_FAILED;
   }
 
+  // Check for extensions used to draw and present only damage
+  const char* const extensions =
+    glXQueryExtensionsString(display, impl->screen);
+
+  surface->bufferAge = puglX11GlHasExtension(extensions, "GLX_EXT_buffer_age");
+  if (puglX11GlHasExtension(extensions, "GLX_MESA_copy_sub_buffer")) {
+    surface->copySubBuffer = (PFNGLXCOPYSUBBUFFERMESAPROC)glXGetProcAddress(
+      (const uint8_t*)"glXCopySubBufferMESA");
+  }
+
+  // Get presentation times from the display if statistics are collected
+  puglX11GlInitPresent(view);
+  PuglX11GlPresent* const present = surface->base.present;
+  if (present && puglX11GlHasExtension(extensions, "GLX_OML_sync_control")) {
+    present->getSyncValues = (PFNGLXGETSYNCVALUESOMLPROC)glXGetProcAddress(
+      (const uint8_t*)"glXGetSyncValuesOML");
+    present->waitForSbc = (PFNGLXWAITFORSBCOMLPROC)glXGetProcAddress(
+      (const uint8_t*)"glXWaitForSbcOML");
+
+    present->stats.precise = present->getSyncValues && present->waitForSbc;
+  }
+
   const int swapInterval = view->hints[PUGL_SWAP_INTERVAL];
   if (glXSwapIntervalEXT && swapInterval != PUGL_DONT_CARE) {
     puglX11GlEnter(view, NULL);
@@ -196,6 +734,14 @@ puglX11GlDestroy(PuglView* view)
 {
   PuglX11GlSurface* surface = (PuglX11GlSurface*)view->impl->surface;
   if (surface) {
+    puglX11GlEndCapture(view, false);
+    puglX11GlFreePresent(view);
+
+    // A sticky context may still be current, which would keep it alive
+    if (surface->ctx && glXGetCurrentContext() == surface->ctx) {
+      glXMakeCurrent(view->impl->display, None, NULL);
+    }
+
     glXDestroyContext(view->impl->display, surface->ctx);
     free(surface);
     view->impl->surface = NULL;
@@ -206,6 +752,13 @@ puglX11GlDestroy(PuglView* view)
 PuglGlFunc
 puglGetProcAddress(const char* name)
 {
+#ifdef HAVE_EGL
+  // Functions may be specific to the API that created the current context
+  if (eglGetCurrentContext() != EGL_NO_CONTEXT) {
+    return eglGetProcAddress(name);
+  }
+#endif
+
   return glXGetProcAddress((const uint8_t*)name);
 }
 
@@ -221,6 +774,472 @@ puglLeaveContext(PuglView* view)
   return view->backend->leave(view, NULL);
 }
 
+PuglStatus
+puglReadPixels(PuglView* const view, void* const pixels, const size_t stride)
+{
+  const int    width    = (int)view->frame.width;
+  const int    height   = (int)view->frame.height;
+  const size_t rowBytes = 4u * (size_t)width;
+  const size_t rowSize  = stride ? stride : rowBytes;
+
+  if (!view->impl->offscreen) {
+    return view->impl->win ? PUGL_UNSUPPORTED_TYPE : PUGL_FAILURE;
+  }
+
+  if (rowSize < rowBytes || rowSize % 4u) {
+    return PUGL_FAILURE;
+  }
+
+  const PuglStatus st = view->backend->enter(view, NULL);
+  if (st) {
+    return st;
+  }
+
+  // Save the pack state, which the application may be using
+  GLint packBuffer    = 0;
+  GLint packAlignment = 4;
+  GLint packRowLength = 0;
+  glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+  glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+  glGetIntegerv(GL_PACK_ROW_LENGTH, &packRowLength);
+
+  // Read into memory, not a pixel buffer object bound by the application
+  const PFNGLBINDBUFFERPROC bindBuffer =
+    packBuffer ? (PFNGLBINDBUFFERPROC)puglGetProcAddress("glBindBuffer") : NULL;
+  if (bindBuffer) {
+    bindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+  }
+
+  // Read every row at once, with the stride as the row length
+  uint8_t* const dst = (uint8_t*)pixels;
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glPixelStorei(GL_PACK_ROW_LENGTH, (GLint)(rowSize / 4u));
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, dst);
+
+  glPixelStorei(GL_PACK_ROW_LENGTH, packRowLength);
+  glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+  if (bindBuffer) {
+    bindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)packBuffer);
+  }
+
+  view->backend->leave(view, NULL);
+
+  // GL rows go from bottom to top, so flip them
+  for (int y = 0; y < height / 2; ++y) {
+    uint8_t* const top    = dst + (size_t)y * rowSize;
+    uint8_t* const bottom = dst + (size_t)(height - 1 - y) * rowSize;
+    for (size_t i = 0u; i < rowBytes; ++i) {
+      const uint8_t byte = top[i];
+      top[i]             = bottom[i];
+      bottom[i]          = byte;
+    }
+  }
+
+  return PUGL_SUCCESS;
+}
+
+/// Return true if the current context supports asynchronous capture
+/// Return the state shared by OpenGL surfaces, or null if there is none
+static PuglX11GlSurfaceBase*
+puglX11GlGetBase(const PuglView* const view)
+{
+  const PuglBackend* const backend = view->backend;
+
+  if (!view->impl->surface ||
+      (backend != puglGlBackend() && backend != puglEglBackend())) {
+    return NULL;
+  }
+
+  return (PuglX11GlSurfaceBase*)view->impl->surface;
+}
+
+static bool
+puglX11GlCanCapture(void)
+{
+  const char* const version = (const char*)glGetString(GL_VERSION);
+  int               major   = 0;
+  int               minor   = 0;
+  if (version && sscanf(version, "%d.%d", &major, &minor) == 2 &&
+      (major > 3 || (major == 3 && minor >= 2))) {
+    return true;
+  }
+
+  const char* const extensions = (const char*)glGetString(GL_EXTENSIONS);
+
+  return puglX11GlHasExtension(extensions, "GL_ARB_pixel_buffer_object") &&
+         puglX11GlHasExtension(extensions, "GL_ARB_map_buffer_range") &&
+         puglX11GlHasExtension(extensions, "GL_ARB_sync");
+}
+
+/// Return true if the oldest frame has been copied, optionally waiting for it
+static bool
+puglX11GlFrameReady(const PuglX11GlCapture* const capture, const bool wait)
+{
+  const GLenum result =
+    capture->clientWaitSync(capture->slots[capture->head].fence,
+                            wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0u,
+                            wait ? PUGL_GL_CAPTURE_TIMEOUT : 0u);
+
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+/// Remove the oldest frame, and pass it to the capture function if requested
+static void
+puglX11GlPopFrame(PuglView* const         view,
+                  PuglX11GlCapture* const capture,
+                  const bool              deliver)
+{
+  PuglX11GlCaptureSlot* const slot = &capture->slots[capture->head];
+
+  if (deliver) {
+    capture->bindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+
+    PuglGlFrame frame = slot->frame;
+    frame.pixels      = capture->mapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)slot->size, GL_MAP_READ_BIT);
+
+    if (frame.pixels) {
+      capture->func(view, &frame);
+      capture->unmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    capture->bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+
+  capture->deleteSync(slot->fence);
+  slot->fence    = NULL;
+  capture->head  = (capture->head + 1u) % PUGL_GL_CAPTURE_FRAMES;
+  capture->count = capture->count - 1u;
+}
+
+void
+puglX11GlCaptureFrame(PuglView* const view)
+{
+  PuglX11GlCapture* const capture = puglX11GlGetBase(view)->capture;
+  if (!capture) {
+    return;
+  }
+
+  // Deliver copied frames, and wait for the oldest if every buffer is in use
+  while (capture->count && puglX11GlFrameReady(capture, false)) {
+    puglX11GlPopFrame(view, capture, true);
+  }
+
+  if (capture->count == PUGL_GL_CAPTURE_FRAMES) {
+    puglX11GlPopFrame(view, capture, puglX11GlFrameReady(capture, true));
+  }
+
+  // Save the pack state, which the application may be using
+  GLint packBuffer    = 0;
+  GLint packAlignment = 4;
+  glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+  glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+
+  // Start copying the frame into the next buffer without waiting for it
+  const size_t index =
+    (capture->head + capture->count) % PUGL_GL_CAPTURE_FRAMES;
+
+  PuglX11GlCaptureSlot* const slot   = &capture->slots[index];
+  const unsigned              width  = (unsigned)view->frame.width;
+  const unsigned              height = (unsigned)view->frame.height;
+  const size_t                stride = 4u * (size_t)width;
+  const size_t                size   = stride * height;
+
+  capture->bindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+  if (slot->size != size) {
+    capture->bufferData(
+      GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_READ);
+    slot->size = size;
+  }
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(
+    0, 0, (GLsizei)width, (GLsizei)height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+  const PuglGlFrame frame = {
+    puglGetTime(view->world), width, height, stride, NULL};
+
+  slot->fence = capture->fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0u);
+  slot->frame = frame;
+  ++capture->count;
+
+  // Make sure the fence is submitted even if nothing is presented
+  glFlush();
+
+  capture->bindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)packBuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+}
+
+void
+puglX11GlEndCapture(PuglView* const view, const bool deliver)
+{
+  PuglX11GlSurfaceBase* const base    = puglX11GlGetBase(view);
+  PuglX11GlCapture* const     capture = base->capture;
+  if (!capture) {
+    return;
+  }
+
+  if (!view->backend->enter(view, NULL)) {
+    while (capture->count) {
+      puglX11GlPopFrame(
+        view, capture, deliver && puglX11GlFrameReady(capture, true));
+    }
+
+    for (size_t i = 0u; i < PUGL_GL_CAPTURE_FRAMES; ++i) {
+      capture->deleteBuffers(1, &capture->slots[i].buffer);
+    }
+
+    view->backend->leave(view, NULL);
+  }
+
+  free(capture);
+  base->capture = NULL;
+}
+
+PuglStatus
+puglStartCapture(PuglView* const view, const PuglGlCaptureFunc func)
+{
+  PuglX11GlSurfaceBase* const base = puglX11GlGetBase(view);
+
+  if (!base) {
+    return PUGL_FAILURE;
+  }
+
+  if (base->capture) {
+    base->capture->func = func;
+    return PUGL_SUCCESS;
+  }
+
+  PuglStatus st = view->backend->enter(view, NULL);
+  if (st) {
+    return st;
+  }
+
+  PuglX11GlCapture* const capture =
+    puglX11GlCanCapture()
+      ? (PuglX11GlCapture*)calloc(1, sizeof(PuglX11GlCapture))
+      : NULL;
+
+  if (capture) {
+    capture->func = func;
+    capture->genBuffers =
+      (PFNGLGENBUFFERSPROC)puglGetProcAddress("glGenBuffers");
+    capture->deleteBuffers =
+      (PFNGLDELETEBUFFERSPROC)puglGetProcAddress("glDeleteBuffers");
+    capture->bindBuffer =
+      (PFNGLBINDBUFFERPROC)puglGetProcAddress("glBindBuffer");
+    capture->bufferData =
+      (PFNGLBUFFERDATAPROC)puglGetProcAddress("glBufferData");
+    capture->mapBufferRange =
+      (PFNGLMAPBUFFERRANGEPROC)puglGetProcAddress("glMapBufferRange");
+    capture->unmapBuffer =
+      (PFNGLUNMAPBUFFERPROC)puglGetProcAddress("glUnmapBuffer");
+    capture->fenceSync = (PFNGLFENCESYNCPROC)puglGetProcAddress("glFenceSync");
+    capture->clientWaitSync =
+      (PFNGLCLIENTWAITSYNCPROC)puglGetProcAddress("glClientWaitSync");
+    capture->deleteSync =
+      (PFNGLDELETESYNCPROC)puglGetProcAddress("glDeleteSync");
+
+    for (size_t i = 0u; i < PUGL_GL_CAPTURE_FRAMES; ++i) {
+      capture->genBuffers(1, &capture->slots[i].buffer);
+    }
+  }
+
+  view->backend->leave(view, NULL);
+
+  base->capture = capture;
+  return capture ? PUGL_SUCCESS : PUGL_UNSUPPORTED_TYPE;
+}
+
+PuglStatus
+puglStopCapture(PuglView* const view)
+{
+  const PuglX11GlSurfaceBase* const base = puglX11GlGetBase(view);
+
+  if (!base || !base->capture) {
+    return PUGL_FAILURE;
+  }
+
+  puglX11GlEndCapture(view, true);
+  return PUGL_SUCCESS;
+}
+
+void
+puglX11GlInitPresent(PuglView* const view)
+{
+  PuglX11GlSurfaceBase* const base = puglX11GlGetBase(view);
+
+  if (view->world->collectingStats && !base->present) {
+    base->present = (PuglX11GlPresent*)calloc(1, sizeof(PuglX11GlPresent));
+  }
+}
+
+/**
+   Add frames presented at some time to the statistics.
+
+   The number of retraces since the first of these frames was issued is
+   negative if unknown, in which case none are counted as missed.
+*/
+static void
+puglX11GlAddFrames(const PuglView* const   view,
+                   PuglGlFrameStats* const stats,
+                   const double            time,
+                   const uint64_t          numFrames,
+                   const int64_t           numVblanks)
+{
+  const int swapInterval = view->hints[PUGL_SWAP_INTERVAL];
+
+  if (stats->numFrames && numFrames) {
+    const double elapsed = time - stats->lastPresentTime;
+    const double ms      = elapsed / (double)numFrames * 1000.0;
+    const size_t last    = PUGL_GL_NUM_INTERVALS - 1u;
+    const size_t bin     = ms < 1.0             ? 0u
+                           : ms >= (double)last ? last
+                                                : (size_t)ms;
+
+    stats->intervals[bin] += numFrames;
+
+    // Frames should be shown every swap interval, so later ones missed some
+    const int64_t expected = (int64_t)numFrames * swapInterval;
+    if (swapInterval > 0 && numVblanks > expected) {
+      stats->missedVblanks += (uint64_t)(numVblanks - expected);
+    }
+  }
+
+  stats->numFrames += numFrames;
+  stats->lastPresentTime = time;
+}
+
+/// Stop using sync control after it failed, and fall back to the clock
+static void
+puglX11GlStopSync(PuglX11GlPresent* const present)
+{
+  present->getSyncValues = NULL;
+  present->waitForSbc    = NULL;
+  present->stats.precise = false;
+}
+
+/// Record any swaps that have been shown since the last call
+static bool
+puglX11GlSyncPresent(PuglView* const         view,
+                     PuglX11GlPresent* const present,
+                     int64_t* const          currentMsc)
+{
+  Display* const          display = view->impl->display;
+  const Window            win     = view->impl->win;
+  PuglGlFrameStats* const stats   = &present->stats;
+  int64_t                 ust     = 0;
+  int64_t                 msc     = 0;
+  int64_t                 sbc     = 0;
+
+  // Get the current retrace count and the count of swaps that were shown
+  if (!present->getSyncValues(display, win, &ust, &msc, &sbc)) {
+    return false;
+  }
+
+  *currentMsc = msc;
+  if (sbc <= stats->lastSbc) {
+    return true;
+  }
+
+  // Get the times of the latest swap that was shown, which doesn't block
+  if (!present->waitForSbc(display, win, sbc, &ust, &msc, &sbc)) {
+    return false;
+  }
+
+  // The UST is from the monotonic clock in microseconds, like our time
+  const double time = (double)ust / 1.0e6 - view->world->startTime;
+
+  puglX11GlAddFrames(view,
+                     stats,
+                     time,
+                     (uint64_t)(sbc - stats->lastSbc),
+                     msc - present->swapMsc);
+
+  // Any later swap was issued before this one was shown, so can't beat it
+  present->swapMsc = msc;
+  stats->lastMsc   = msc;
+  stats->lastSbc   = sbc;
+  return true;
+}
+
+void
+puglX11GlBeginPresent(PuglView* const view)
+{
+  PuglX11GlPresent* const present = puglX11GlGetBase(view)->present;
+  if (!present) {
+    return;
+  }
+
+  present->swapTime = puglGetTime(view->world);
+  if (present->getSyncValues) {
+    int64_t msc = 0;
+    if (!puglX11GlSyncPresent(view, present, &msc)) {
+      puglX11GlStopSync(present);
+    } else if (present->stats.lastSbc >= present->issuedSbc) {
+      // Nothing is waiting to be shown, so this can be shown at the next one
+      present->swapMsc = msc;
+    }
+  }
+}
+
+void
+puglX11GlRecordPresent(PuglView* const view, const bool swapped)
+{
+  PuglX11GlPresent* const present = puglX11GlGetBase(view)->present;
+  if (!present) {
+    return;
+  }
+
+  PuglGlFrameStats* const stats = &present->stats;
+  if (swapped && present->getSyncValues) {
+    const int64_t lastSbc = stats->lastSbc;
+    int64_t       msc     = 0;
+
+    present->issuedSbc =
+      (present->issuedSbc > lastSbc ? present->issuedSbc : lastSbc) + 1;
+
+    if (puglX11GlSyncPresent(view, present, &msc)) {
+      return;
+    }
+
+    // Sync control failed, so fall back to using the clock from now on
+    puglX11GlStopSync(present);
+  }
+
+  // Estimate the retraces that passed while this frame was being presented
+  const double  time        = puglGetTime(view->world);
+  const int     refreshRate = view->hints[PUGL_REFRESH_RATE];
+  const int64_t numVblanks =
+    refreshRate > 0
+      ? (int64_t)((time - present->swapTime) * (double)refreshRate)
+      : -1;
+
+  puglX11GlAddFrames(view, stats, time, 1u, numVblanks);
+}
+
+void
+puglX11GlFreePresent(PuglView* const view)
+{
+  PuglX11GlSurfaceBase* const base = puglX11GlGetBase(view);
+
+  free(base->present);
+  base->present = NULL;
+}
+
+PuglStatus
+puglGetFrameStats(const PuglView* const view, PuglGlFrameStats* const stats)
+{
+  const PuglX11GlSurfaceBase* const base = puglX11GlGetBase(view);
+
+  if (!base || !base->present) {
+    return PUGL_FAILURE;
+  }
+
+  *stats = base->present->stats;
+  return PUGL_SUCCESS;
+}
+
 const PuglBackend*
 puglGlBackend(void)
 {
@@ -233,3 +1252,11 @@ puglGlBackend(void)
 
   return &backend;
 }
+
+#ifndef HAVE_EGL
+const PuglBackend*
+puglEglBackend(void)
+{
+  return NULL;
+}
+#endif
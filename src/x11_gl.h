@@ -0,0 +1,88 @@
+/*
+  Copyright 2012-2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef PUGL_DETAIL_X11_GL_H
+#define PUGL_DETAIL_X11_GL_H
+
+#include "types.h"
+
+#include "pugl/pugl.h"
+
+#include <stdbool.h>
+
+/// OpenGL frame capture state for a view, see x11_gl.c
+typedef struct PuglX11GlCaptureImpl PuglX11GlCapture;
+
+/// OpenGL presentation statistics for a view, see x11_gl.c
+typedef struct PuglX11GlPresentImpl PuglX11GlPresent;
+
+/// Number of frames of damage kept for redrawing older OpenGL back buffers
+#define PUGL_GL_MAX_BUFFER_AGE 4u
+
+/// Damage of the last frames drawn to an OpenGL view, see x11_gl.c
+typedef struct {
+  PuglRect rects[PUGL_GL_MAX_BUFFER_AGE]; ///< Bounds of damage, newest first
+  unsigned numRects;                      ///< Number of frames in history
+  PuglRect frame;                         ///< Bounds of damage being drawn
+  bool     clipped;                       ///< True if clipped to `frame`
+} PuglX11GlHistory;
+
+/// State shared by the GLX and EGL surfaces, which both start with it
+typedef struct {
+  PuglX11GlCapture* capture; ///< Frame capture state, or null
+  PuglX11GlPresent* present; ///< Presentation statistics, or null
+} PuglX11GlSurfaceBase;
+
+/// Return true if only damage is drawn and presented for an OpenGL expose
+bool
+puglX11GlIsPartial(const PuglView* view);
+
+/// Clip drawing to the damage that must be drawn to a buffer of some age
+void
+puglX11GlClipDamage(PuglView*              view,
+                    const PuglEventExpose* expose,
+                    PuglX11GlHistory*      history,
+                    unsigned               age);
+
+/// Stop clipping drawing, and add the damage that was drawn to the history
+void
+puglX11GlEndDamage(PuglX11GlHistory* history);
+
+/// Capture the frame about to be presented, if capture is running
+void
+puglX11GlCaptureFrame(PuglView* view);
+
+/// Stop frame capture, optionally delivering frames still being copied
+void
+puglX11GlEndCapture(PuglView* view, bool deliver);
+
+/// Start collecting presentation statistics if the world collects stats
+void
+puglX11GlInitPresent(PuglView* view);
+
+/// Note that a frame is about to be presented, before swapping buffers
+void
+puglX11GlBeginPresent(PuglView* view);
+
+/// Record a presented frame, which was swapped to the screen if `swapped`
+void
+puglX11GlRecordPresent(PuglView* view, bool swapped);
+
+/// Free presentation statistics
+void
+puglX11GlFreePresent(PuglView* view);
+
+#endif // PUGL_DETAIL_X11_GL_H
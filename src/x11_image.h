@@ -0,0 +1,183 @@
+/*
+  Copyright 2012-2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef PUGL_DETAIL_X11_IMAGE_H
+#define PUGL_DETAIL_X11_IMAGE_H
+
+#include "pugl/pugl.h"
+
+#include <X11/X.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#ifdef HAVE_XSHM
+#  include <X11/extensions/XShm.h>
+#  include <sys/ipc.h>
+#  include <sys/shm.h>
+#endif
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Return true if an image has native 32-bit words with 8-bit RGB channels
+static inline bool
+puglX11IsRgb32Image(const XImage* const image)
+{
+  static const uint32_t one    = 1u;
+  const int             native = *(const uint8_t*)&one ? LSBFirst : MSBFirst;
+
+  return (image->depth == 24 || image->depth == 32) &&
+         image->bits_per_pixel == 32 && image->byte_order == native &&
+         image->red_mask == 0xFF0000 && image->green_mask == 0x00FF00 &&
+         image->blue_mask == 0x0000FF;
+}
+
+/**
+   Get the pixel area of a rectangle, clamped to the bounds of an image.
+
+   @return True if the area is not empty.
+*/
+static inline bool
+puglX11ImageArea(const XImage* const   image,
+                 const PuglRect* const rect,
+                 int* const            x,
+                 int* const            y,
+                 unsigned* const       width,
+                 unsigned* const       height)
+{
+  const double imageWidth  = (double)image->width;
+  const double imageHeight = (double)image->height;
+
+  const double left   = fmax(0.0, floor(rect->x));
+  const double top    = fmax(0.0, floor(rect->y));
+  const double right  = fmin(imageWidth, ceil(rect->x + rect->width));
+  const double bottom = fmin(imageHeight, ceil(rect->y + rect->height));
+
+  if (right <= left || bottom <= top) {
+    return false;
+  }
+
+  *x      = (int)left;
+  *y      = (int)top;
+  *width  = (unsigned)(right - left);
+  *height = (unsigned)(bottom - top);
+  return true;
+}
+
+#ifdef HAVE_XSHM
+
+static bool puglX11ShmError = false;
+
+static inline int
+puglX11ShmErrorHandler(Display* const display, XErrorEvent* const event)
+{
+  (void)display;
+  (void)event;
+
+  puglX11ShmError = true;
+  return 0;
+}
+
+/**
+   Create an RGB image in a new shared memory segment.
+
+   This costs a round trip to check that the server could attach the segment,
+   which fails for remote displays, so images should be kept and only
+   recreated when the size changes.
+
+   @return The new image, or null if the visual isn't RGB with 32-bit pixels
+   or the segment couldn't be shared with the server.
+*/
+static inline XImage*
+puglX11ShmCreateImage(Display* const           display,
+                      const XVisualInfo* const vi,
+                      const int                width,
+                      const int                height,
+                      XShmSegmentInfo* const   info)
+{
+  XImage* const image = XShmCreateImage(display,
+                                        vi->visual,
+                                        (unsigned)vi->depth,
+                                        ZPixmap,
+                                        NULL,
+                                        info,
+                                        (unsigned)width,
+                                        (unsigned)height);
+
+  if (!image) {
+    return NULL;
+  }
+
+  const size_t size = (size_t)image->bytes_per_line * (size_t)image->height;
+
+  info->shmid =
+    puglX11IsRgb32Image(image) ? shmget(IPC_PRIVATE, size, 0600) : -1;
+
+  if (info->shmid < 0) {
+    XDestroyImage(image);
+    return NULL;
+  }
+
+  info->shmaddr  = (char*)shmat(info->shmid, NULL, 0);
+  info->readOnly = False;
+  image->data    = info->shmaddr;
+
+  // Attach the segment, trapping the error if the server can't access it
+  bool attached = false;
+  if (info->shmaddr != (char*)-1) {
+    int (*const oldHandler)(Display*, XErrorEvent*) =
+      XSetErrorHandler(puglX11ShmErrorHandler);
+
+    puglX11ShmError = false;
+    attached        = XShmAttach(display, info);
+    XSync(display, False);
+    attached = attached && !puglX11ShmError;
+    XSetErrorHandler(oldHandler);
+  }
+
+  // Mark the segment for removal so it is freed when everything detaches
+  shmctl(info->shmid, IPC_RMID, NULL);
+
+  if (!attached) {
+    if (info->shmaddr != (char*)-1) {
+      shmdt(info->shmaddr);
+    }
+
+    image->data = NULL;
+    XDestroyImage(image);
+    return NULL;
+  }
+
+  return image;
+}
+
+/// Detach and destroy an image created with puglX11ShmCreateImage()
+static inline void
+puglX11ShmDestroyImage(Display* const         display,
+                       XImage* const          image,
+                       XShmSegmentInfo* const info)
+{
+  XShmDetach(display, info);
+  image->data = NULL;
+  XDestroyImage(image);
+  shmdt(info->shmaddr);
+}
+
+#endif // HAVE_XSHM
+
+#endif // PUGL_DETAIL_X11_IMAGE_H
@@ -0,0 +1,323 @@
+/*
+  Copyright 2012-2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "types.h"
+#include "x11.h"
+#include "x11_image.h"
+
+#include "pugl/pixel.h"
+#include "pugl/pugl.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#define PUGL_MAX_PIXEL_IMAGES 2u
+
+typedef struct {
+  XImage* image;  ///< Image of the whole view, or null
+  size_t  serial; ///< Serial of the last request that reads the image
+#ifdef HAVE_XSHM
+  XShmSegmentInfo shmInfo; ///< Shared memory segment, if shared
+#endif
+} PuglX11PixelImage;
+
+typedef struct {
+  PuglX11PixelImage images[PUGL_MAX_PIXEL_IMAGES];
+  unsigned          numImages; ///< Number of images used in turn
+  unsigned          current;   ///< Index of image to draw next
+  GC                gc;        ///< Graphics context for putting images
+  PuglPixelBuffer   buffer;    ///< Buffer for the current image
+  bool              drawing;   ///< True if the buffer may be drawn to
+  bool              shared;    ///< True if images are in shared memory
+} PuglX11PixelSurface;
+
+static void
+puglX11PixelClose(PuglView* view)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11PixelSurface* const surface = (PuglX11PixelSurface*)impl->surface;
+
+  for (unsigned i = 0u; i < surface->numImages; ++i) {
+    PuglX11PixelImage* const image = &surface->images[i];
+
+#ifdef HAVE_XSHM
+    if (image->image && surface->shared) {
+      puglX11ShmDestroyImage(impl->display, image->image, &image->shmInfo);
+      image->image = NULL;
+    }
+#endif
+
+    if (image->image) {
+      XDestroyImage(image->image);
+      image->image = NULL;
+    }
+  }
+
+  surface->numImages = 0u;
+  surface->current   = 0u;
+}
+
+/// Create an image of the view in client memory
+static XImage*
+puglX11PixelCreateImage(PuglView* view, const int width, const int height)
+{
+  PuglInternals* const impl  = view->impl;
+  XImage* const        image = XCreateImage(impl->display,
+                                     impl->vi->visual,
+                                     (unsigned)impl->vi->depth,
+                                     ZPixmap,
+                                     0,
+                                     NULL,
+                                     (unsigned)width,
+                                     (unsigned)height,
+                                     32,
+                                     0);
+
+  if (image && puglX11IsRgb32Image(image)) {
+    image->data = (char*)calloc((size_t)image->height,
+                                (size_t)image->bytes_per_line);
+    if (image->data) {
+      return image;
+    }
+  }
+
+  if (image) {
+    XDestroyImage(image);
+  }
+
+  return NULL;
+}
+
+/**
+   Create images the size of the view.
+
+   With shared memory, two images are used in turn, so the next frame can be
+   drawn while the server may still be reading the last.  Otherwise, the
+   pixels are copied when they are put, so one image is enough.
+*/
+static PuglStatus
+puglX11PixelOpen(PuglView* view)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11PixelSurface* const surface = (PuglX11PixelSurface*)impl->surface;
+  const int                  width   = (int)view->frame.width;
+  const int                  height  = (int)view->frame.height;
+
+  puglX11PixelClose(view);
+
+#ifdef HAVE_XSHM
+  if (surface->shared) {
+    for (unsigned i = 0u; i < PUGL_MAX_PIXEL_IMAGES; ++i) {
+      PuglX11PixelImage* const image = &surface->images[i];
+
+      image->serial = 0u;
+      image->image  = puglX11ShmCreateImage(
+        impl->display, impl->vi, width, height, &image->shmInfo);
+
+      if (!image->image) {
+        // Fall back to client memory, for example for remote displays
+        puglX11PixelClose(view);
+        surface->shared = false;
+        break;
+      }
+
+      ++surface->numImages;
+    }
+  }
+#endif
+
+  if (!surface->numImages) {
+    surface->images[0].serial = 0u;
+    surface->images[0].image  = puglX11PixelCreateImage(view, width, height);
+    if (!surface->images[0].image) {
+      return PUGL_CREATE_CONTEXT_FAILED;
+    }
+
+    surface->numImages = 1u;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+/// Put a rectangle of an image to the window, clamped to the image bounds
+static void
+puglX11PixelPutRect(PuglView* view, XImage* const image, const PuglRect* rect)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11PixelSurface* const surface = (PuglX11PixelSurface*)impl->surface;
+  int                        x       = 0;
+  int                        y       = 0;
+  unsigned                   width   = 0u;
+  unsigned                   height  = 0u;
+
+  if (!puglX11ImageArea(image, rect, &x, &y, &width, &height)) {
+    return;
+  }
+
+#ifdef HAVE_XSHM
+  if (surface->shared) {
+    XShmPutImage(impl->display,
+                 impl->win,
+                 surface->gc,
+                 image,
+                 x,
+                 y,
+                 x,
+                 y,
+                 width,
+                 height,
+                 False);
+    return;
+  }
+#endif
+
+  XPutImage(
+    impl->display, impl->win, surface->gc, image, x, y, x, y, width, height);
+}
+
+static PuglStatus
+puglX11PixelCreate(PuglView* view)
+{
+  PuglInternals* const       impl = view->impl;
+  PuglX11PixelSurface* const surface =
+    (PuglX11PixelSurface*)calloc(1, sizeof(PuglX11PixelSurface));
+
+  if (!surface) {
+    return PUGL_CREATE_CONTEXT_FAILED;
+  }
+
+  impl->surface = (PuglSurface*)surface;
+  surface->gc   = XCreateGC(impl->display, impl->win, 0, NULL);
+
+#ifdef HAVE_XSHM
+  surface->shared = XShmQueryExtension(impl->display);
+#endif
+
+  return surface->gc ? PUGL_SUCCESS : PUGL_CREATE_CONTEXT_FAILED;
+}
+
+static PuglStatus
+puglX11PixelDestroy(PuglView* view)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11PixelSurface* const surface = (PuglX11PixelSurface*)impl->surface;
+
+  if (surface) {
+    puglX11PixelClose(view);
+    if (surface->gc) {
+      XFreeGC(impl->display, surface->gc);
+    }
+
+    free(surface);
+    impl->surface = NULL;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static PuglStatus
+puglX11PixelEnter(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11PixelSurface* const surface = (PuglX11PixelSurface*)impl->surface;
+  PuglStatus                 st      = PUGL_SUCCESS;
+
+  if (!expose) {
+    return PUGL_SUCCESS;
+  }
+
+  // Recreate the images if the view has been resized
+  const XImage* const first = surface->images[0].image;
+  if (!first || first->width != (int)view->frame.width ||
+      first->height != (int)view->frame.height) {
+    if ((st = puglX11PixelOpen(view))) {
+      return st;
+    }
+  }
+
+  // Wait for the server if it may still be reading this image
+  PuglX11PixelImage* const image = &surface->images[surface->current];
+  if (surface->shared && image->serial &&
+      LastKnownRequestProcessed(impl->display) < image->serial) {
+    XSync(impl->display, False);
+  }
+
+  surface->buffer.data   = image->image->data;
+  surface->buffer.stride = (size_t)image->image->bytes_per_line;
+  surface->buffer.width  = (unsigned)image->image->width;
+  surface->buffer.height = (unsigned)image->image->height;
+  surface->buffer.format =
+    image->image->depth == 32 ? PUGL_PIXEL_ARGB32 : PUGL_PIXEL_XRGB32;
+  surface->drawing       = true;
+
+  return PUGL_SUCCESS;
+}
+
+static PuglStatus
+puglX11PixelLeave(PuglView* view, const PuglEventExpose* expose)
+{
+  PuglInternals* const       impl    = view->impl;
+  PuglX11PixelSurface* const surface = (PuglX11PixelSurface*)impl->surface;
+
+  if (!expose || !surface->drawing) {
+    return PUGL_SUCCESS;
+  }
+
+  PuglX11PixelImage* const image = &surface->images[surface->current];
+
+  // Put only the damaged region to the window
+  if (view->damage.numRects) {
+    for (size_t i = 0; i < view->damage.numRects; ++i) {
+      puglX11PixelPutRect(view, image->image, &view->damage.rects[i]);
+    }
+  } else {
+    const PuglRect rect = {expose->x, expose->y, expose->width, expose->height};
+    puglX11PixelPutRect(view, image->image, &rect);
+  }
+
+  // Remember the last request that reads the image, and use the next one
+  image->serial    = NextRequest(impl->display) - 1u;
+  surface->current = (surface->current + 1u) % surface->numImages;
+  surface->drawing = false;
+
+  return PUGL_SUCCESS;
+}
+
+static void*
+puglX11PixelGetContext(PuglView* view)
+{
+  PuglX11PixelSurface* const surface =
+    (PuglX11PixelSurface*)view->impl->surface;
+
+  return surface->drawing ? &surface->buffer : NULL;
+}
+
+const PuglBackend*
+puglPixelBackend(void)
+{
+  static const PuglBackend backend = {puglX11StubConfigure,
+                                      puglX11PixelCreate,
+                                      puglX11PixelDestroy,
+                                      puglX11PixelEnter,
+                                      puglX11PixelLeave,
+                                      puglX11PixelGetContext};
+
+  return &backend;
+}
@@ -31,6 +31,10 @@ puglX11StubConfigure(PuglView* view)
   XVisualInfo          pat  = {0};
   int                  n    = 0;
 
+  if (!impl->display) {
+    return PUGL_BACKEND_FAILED; // Headless drawing isn't supported
+  }
+
   pat.screen = impl->screen;
   impl->vi   = XGetVisualInfo(impl->display, VisualScreenMask, &pat, &n);
 
@@ -0,0 +1,139 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Measures the cost of drawing frames with the Cairo backends.
+
+  The whole view is redrawn in every frame, and the time and number of
+  requests sent to the X server per frame are reported.  Creating and
+  destroying surfaces requires requests to allocate and free pixmaps on the
+  server, so this shows if any are allocated when drawing a frame.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#undef NDEBUG
+
+#include "pugl/cairo.h"
+#include "pugl/pugl.h"
+
+#include <X11/Xlib.h>
+#include <cairo.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+  const char*        name;
+  const PuglBackend* backend;
+} Backend;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  size_t* const numExposes = (size_t*)puglGetHandle(view);
+
+  if (event->type == PUGL_EXPOSE) {
+    cairo_t* const cr    = (cairo_t*)puglGetContext(view);
+    const double   shade = (double)(*numExposes % 256u) / 255.0;
+
+    cairo_set_source_rgb(cr, shade, 0.5, 1.0 - shade);
+    cairo_paint(cr);
+    ++*numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static void
+drawFrame(PuglWorld* const world, PuglView* const view)
+{
+  const size_t* const numExposes = (const size_t*)puglGetHandle(view);
+  const size_t        target     = *numExposes + 1u;
+
+  assert(!puglPostRedisplay(view));
+  while (*numExposes < target) {
+    assert(!puglUpdate(world, -1.0));
+  }
+}
+
+static void
+benchmark(const Backend* const backend, const size_t numFrames)
+{
+  PuglWorld* const world      = puglNewWorld(PUGL_PROGRAM, 0);
+  Display* const   display    = (Display*)puglGetNativeWorld(world);
+  PuglView* const  view       = puglNewView(world);
+  size_t           numExposes = 0u;
+
+  puglSetClassName(world, "Pugl Cairo Benchmark");
+  puglSetBackend(view, backend->backend);
+  puglSetHandle(view, &numExposes);
+  puglSetEventFunc(view, onEvent);
+  puglSetDefaultSize(view, 512, 512);
+  assert(!puglRealize(view));
+  assert(!puglShow(view));
+
+  // Wait for the first expose, and draw a frame so everything is set up
+  while (!numExposes) {
+    assert(!puglUpdate(world, -1.0));
+  }
+  drawFrame(world, view);
+
+  const unsigned long startRequests = XNextRequest(display);
+  const double        startTime     = now();
+  for (size_t i = 0u; i < numFrames; ++i) {
+    drawFrame(world, view);
+  }
+  const double        endTime     = now();
+  const unsigned long endRequests = XNextRequest(display);
+
+  printf("%s\t%.1f\t%.1f\n",
+         backend->name,
+         (endTime - startTime) / (double)numFrames * 1.0e6,
+         (double)(endRequests - startRequests) / (double)numFrames);
+
+  puglFreeView(view);
+  puglFreeWorld(world);
+}
+
+int
+main(int argc, char** argv)
+{
+  const size_t numFrames =
+    argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : (size_t)1000u;
+
+  const Backend backends[] = {
+    {"cairo", puglCairoBackend()},
+    {"cairo_shm", puglCairoShmBackend()},
+  };
+
+  printf("# Backend\tus/frame\trequests/frame\n");
+  for (size_t i = 0u; i < sizeof(backends) / sizeof(backends[0]); ++i) {
+    benchmark(&backends[i], numFrames);
+  }
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Measures how drawing a large view in tiles scales with the number of threads.
+
+  Every frame redraws the whole view, which has a dense waveform drawn with
+  antialiased lines, so the time is dominated by rasterization.  The time per
+  frame and the speedup over drawing with a single thread is reported for
+  each number of threads.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#undef NDEBUG
+
+#include "pugl/cairo.h"
+#include "pugl/pugl.h"
+
+#include <cairo.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static const int    width     = 3840;
+static const int    height    = 1024;
+static const size_t numFrames = 20u;
+
+static void
+drawTile(PuglView* view, void* context, PuglRect tile)
+{
+  (void)view;
+
+  cairo_t* const cr = (cairo_t*)context;
+
+  cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
+  cairo_paint(cr);
+
+  // Draw a dense waveform with several points per pixel
+  const double mid = height / 2.0;
+  cairo_set_source_rgb(cr, 0.4, 0.8, 0.4);
+  cairo_set_line_width(cr, 1.5);
+  cairo_move_to(cr, tile.x, mid);
+  for (double x = tile.x; x <= tile.x + tile.width; x += 0.25) {
+    const double y = mid + mid * 0.8 * sin(x * 0.05) * cos(x * 0.0071) *
+                             sin(x * 1.3);
+
+    cairo_line_to(cr, x, y);
+  }
+
+  cairo_stroke(cr);
+}
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  size_t* const numExposes = (size_t*)puglGetHandle(view);
+
+  if (event->type == PUGL_EXPOSE) {
+    ++*numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static double
+benchmark(PuglWorld* const world, PuglView* const view, const unsigned n)
+{
+  size_t* const numExposes = (size_t*)puglGetHandle(view);
+
+  assert(!puglSetCairoTileFunc(view, drawTile, n));
+
+  const double startTime = puglGetTime(world);
+  for (size_t i = 0u; i < numFrames; ++i) {
+    const size_t target = *numExposes + 1u;
+
+    assert(!puglPostRedisplay(view));
+    while (*numExposes < target) {
+      assert(!puglUpdate(world, -1.0));
+    }
+  }
+
+  return (puglGetTime(world) - startTime) / (double)numFrames;
+}
+
+int
+main(int argc, char** argv)
+{
+  const long     numCpus    = sysconf(_SC_NPROCESSORS_ONLN);
+  const unsigned maxThreads = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10)
+                              : numCpus > 0 ? (unsigned)numCpus
+                                            : 1u;
+
+  PuglWorld* const world      = puglNewWorld(PUGL_PROGRAM, 0);
+  PuglView* const  view       = puglNewView(world);
+  size_t           numExposes = 0u;
+
+  puglSetClassName(world, "Pugl Cairo Tiles Benchmark");
+  puglSetBackend(view, puglCairoBackend());
+  puglSetHandle(view, &numExposes);
+  puglSetEventFunc(view, onEvent);
+  puglSetDefaultSize(view, width, height);
+  assert(!puglRealize(view));
+  assert(!puglShow(view));
+  while (!numExposes) {
+    assert(!puglUpdate(world, -1.0));
+  }
+
+  printf("# Threads\tms/frame\tspeedup\n");
+  const double baseline = benchmark(world, view, 1u);
+  printf("1\t%.2f\t1.00\n", baseline * 1000.0);
+  for (unsigned n = 2u; n <= maxThreads; ++n) {
+    const double time = benchmark(world, view, n);
+    printf("%u\t%.2f\t%.2f\n", n, time * 1000.0, baseline / time);
+  }
+
+  puglFreeView(view);
+  puglFreeWorld(world);
+
+  return 0;
+}
@@ -0,0 +1,122 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Measures the cost of dispatching X events as the number of views in a world
+  grows.
+
+  Synthetic motion events are spread over all views and pushed directly onto
+  the local Xlib queue, so the time measured is that of pugl finding the view
+  and translating and dispatching the event, not of the server.  The time per
+  event should stay roughly constant regardless of the number of views.
+*/
+
+#undef NDEBUG
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <X11/Xlib.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t numEvents = 200000u;
+static const size_t batchSize = 1000u;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  size_t* const numMotions = (size_t*)puglGetHandle(view);
+
+  if (event->type == PUGL_MOTION) {
+    ++*numMotions;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static double
+benchmark(const size_t numViews)
+{
+  PuglWorld* const world      = puglNewWorld(PUGL_PROGRAM, 0);
+  PuglView** const views      = (PuglView**)calloc(numViews, sizeof(PuglView*));
+  Display* const   display    = (Display*)puglGetNativeWorld(world);
+  size_t           numMotions = 0u;
+
+  puglSetClassName(world, "Pugl Dispatch Benchmark");
+
+  for (size_t i = 0u; i < numViews; ++i) {
+    views[i] = puglNewView(world);
+    puglSetBackend(views[i], puglStubBackend());
+    puglSetHandle(views[i], &numMotions);
+    puglSetEventFunc(views[i], onEvent);
+    puglSetDefaultSize(views[i], 64, 64);
+    assert(!puglRealize(views[i]));
+  }
+
+  // Drain any events generated by creating the windows
+  assert(!puglUpdate(world, 0.0));
+
+  XEvent xevent;
+  memset(&xevent, 0, sizeof(xevent));
+  xevent.xmotion.type    = MotionNotify;
+  xevent.xmotion.display = display;
+  xevent.xmotion.x       = 32;
+  xevent.xmotion.y       = 32;
+
+  const double startTime = puglGetTime(world);
+  for (size_t i = 0u; i < numEvents; i += batchSize) {
+    for (size_t j = 0u; j < batchSize; ++j) {
+      // Stride through the views so lookups do not hit the same one in a row
+      const size_t v = ((i + j) * 7919u) % numViews;
+
+      xevent.xmotion.window = (Window)puglGetNativeWindow(views[v]);
+      xevent.xmotion.time   = (Time)(i + j);
+      XPutBackEvent(display, &xevent);
+    }
+
+    assert(!puglUpdate(world, 0.0));
+  }
+  const double endTime = puglGetTime(world);
+
+  assert(numMotions == numEvents);
+
+  for (size_t i = 0u; i < numViews; ++i) {
+    puglFreeView(views[i]);
+  }
+
+  free(views);
+  puglFreeWorld(world);
+
+  return (endTime - startTime) / (double)numEvents;
+}
+
+int
+main(int argc, char** argv)
+{
+  const size_t maxViews =
+    argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : (size_t)1000u;
+
+  printf("# Views\tns/event\n");
+  for (size_t n = 1u; n <= maxViews; n *= 10u) {
+    printf("%zu\t%.1f\n", n, benchmark(n) * 1.0e9);
+  }
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Measures the cost of entering and leaving GL contexts, with and without the
+  sticky context hint.
+
+  Views are entered in turn, as a host does when updating many plugin UIs
+  every frame.  With one view, a sticky context never needs to be switched,
+  so entering and leaving should be almost free.  With several views, the
+  context still has to be switched, but is no longer released in between.
+*/
+
+#undef NDEBUG
+
+#include "pugl/gl.h"
+#include "pugl/pugl.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const size_t numPairs = 100000u;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  (void)view;
+  (void)event;
+
+  return PUGL_SUCCESS;
+}
+
+static double
+benchmark(const size_t numViews, const bool sticky)
+{
+  PuglWorld* const world = puglNewWorld(PUGL_PROGRAM, 0);
+  PuglView** const views = (PuglView**)calloc(numViews, sizeof(PuglView*));
+
+  puglSetClassName(world, "Pugl GL Context Benchmark");
+
+  for (size_t i = 0u; i < numViews; ++i) {
+    views[i] = puglNewView(world);
+    puglSetBackend(views[i], puglGlBackend());
+    puglSetEventFunc(views[i], onEvent);
+    puglSetDefaultSize(views[i], 64, 64);
+    puglSetViewHint(views[i], PUGL_STICKY_CONTEXT, sticky);
+    assert(!puglRealize(views[i]));
+  }
+
+  const double startTime = puglGetTime(world);
+  for (size_t i = 0u; i < numPairs; ++i) {
+    PuglView* const view = views[i % numViews];
+
+    assert(!puglEnterContext(view));
+    assert(!puglLeaveContext(view));
+  }
+  const double endTime = puglGetTime(world);
+
+  for (size_t i = 0u; i < numViews; ++i) {
+    puglFreeView(views[i]);
+  }
+
+  free(views);
+  puglFreeWorld(world);
+
+  return (endTime - startTime) / (double)numPairs;
+}
+
+int
+main(int argc, char** argv)
+{
+  const size_t maxViews =
+    argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : (size_t)16u;
+
+  printf("# Views\tns/pair\tsticky ns/pair\n");
+  for (size_t n = 1u; n <= maxViews; n *= 4u) {
+    const double normal = benchmark(n, false);
+    const double sticky = benchmark(n, true);
+
+    printf("%zu\t%.1f\t%.1f\n", n, normal * 1.0e9, sticky * 1.0e9);
+  }
+
+  return 0;
+}
@@ -0,0 +1,126 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Measures the cost of drawing a GL view offscreen in a headless world.
+
+  Every frame clears the view and fills many small scissored rectangles, then
+  the result is read back once at the end.  Since nothing is presented, this
+  measures drawing alone, without any X server or compositor in the way.
+*/
+
+#undef NDEBUG
+
+#include "pugl/gl.h"
+#include "pugl/pugl.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const size_t numFrames = 200u;
+static const int    numRects  = 256;
+
+typedef struct {
+  size_t numExposes;
+} PuglBench;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglBench* const bench = (PuglBench*)puglGetHandle(view);
+  const PuglRect   frame = puglGetFrame(view);
+
+  if (event->type == PUGL_CONFIGURE) {
+    glViewport(0, 0, (int)frame.width, (int)frame.height);
+  } else if (event->type == PUGL_EXPOSE) {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Fill a grid of rectangles that covers the view
+    const int cellWidth  = (int)frame.width / 16;
+    const int cellHeight = (int)frame.height / (numRects / 16);
+
+    glEnable(GL_SCISSOR_TEST);
+    for (int i = 0; i < numRects; ++i) {
+      const float shade = (float)i / (float)numRects;
+
+      glScissor((i % 16) * cellWidth,
+                (i / 16) * cellHeight,
+                cellWidth - 1,
+                cellHeight - 1);
+      glClearColor(shade, 1.0f - shade, 0.5f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+
+    ++bench->numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static double
+benchmark(const int size)
+{
+  PuglWorld* const world = puglNewWorld(PUGL_PROGRAM, PUGL_WORLD_HEADLESS);
+  PuglView* const  view  = puglNewView(world);
+  PuglBench        bench = {0u};
+
+  assert(world);
+  puglSetClassName(world, "Pugl GL Headless Benchmark");
+  puglSetBackend(view, puglEglBackend());
+  puglSetHandle(view, &bench);
+  puglSetEventFunc(view, onEvent);
+  puglSetDefaultSize(view, size, size);
+  assert(!puglShow(view));
+  while (!bench.numExposes) {
+    assert(!puglUpdate(world, -1.0));
+  }
+
+  // Draw frames, then read back the last one which waits for it to finish
+  uint8_t* const pixels    = (uint8_t*)calloc((size_t)size * 4u, (size_t)size);
+  const double   startTime = puglGetTime(world);
+  for (size_t i = 0u; i < numFrames; ++i) {
+    assert(!puglPostRedisplay(view));
+    assert(!puglUpdate(world, 0.0));
+  }
+
+  assert(!puglReadPixels(view, pixels, 0u));
+  const double endTime = puglGetTime(world);
+
+  assert(bench.numExposes == numFrames + 1u);
+
+  free(pixels);
+  puglFreeView(view);
+  puglFreeWorld(world);
+
+  return (endTime - startTime) / (double)numFrames;
+}
+
+int
+main(int argc, char** argv)
+{
+  const int maxSize = argc > 1 ? (int)strtol(argv[1], NULL, 10) : 2048;
+
+  printf("# Size\tms/frame\n");
+  for (int size = 256; size <= maxSize; size *= 2) {
+    printf("%d\t%.3f\n", size, benchmark(size) * 1.0e3);
+  }
+
+  return 0;
+}
@@ -0,0 +1,141 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Measures the cost of starting up, from creating a world to the first expose
+  of a view, as a plugin host would do every time a plugin UI is opened.
+
+  The number of requests sent to the X server in each phase is reported along
+  with the time taken.  Xlib doesn't count round trips, but these dominate the
+  time when the server is remote, so this is best run with some latency, for
+  example with a remote display, to see their effect.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#undef NDEBUG
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <X11/Xlib.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NUM_PHASES 3u
+
+static const char* const phaseNames[NUM_PHASES] = {
+  "new world",
+  "realize",
+  "first expose",
+};
+
+typedef struct {
+  double        time;
+  unsigned long requests;
+} Measurement;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  bool* const exposed = (bool*)puglGetHandle(view);
+
+  if (event->type == PUGL_EXPOSE) {
+    *exposed = true;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static Measurement
+measure(Display* const display)
+{
+  const Measurement measurement = {now(), XNextRequest(display)};
+  return measurement;
+}
+
+static void
+run(Measurement results[NUM_PHASES])
+{
+  Measurement marks[NUM_PHASES + 1u];
+  bool        exposed = false;
+
+  const double     startTime = now();
+  PuglWorld* const world     = puglNewWorld(PUGL_MODULE, 0);
+  Display* const   display   = (Display*)puglGetNativeWorld(world);
+
+  // Count requests from the start, including those made to open the display
+  marks[0].time     = startTime;
+  marks[0].requests = 1u;
+  marks[1]          = measure(display);
+
+  PuglView* const view = puglNewView(world);
+  puglSetClassName(world, "Pugl Startup Benchmark");
+  puglSetBackend(view, puglStubBackend());
+  puglSetHandle(view, &exposed);
+  puglSetEventFunc(view, onEvent);
+  puglSetDefaultSize(view, 256, 256);
+  assert(!puglRealize(view));
+  marks[2] = measure(display);
+
+  assert(!puglShow(view));
+  while (!exposed) {
+    assert(!puglUpdate(world, -1.0));
+  }
+  marks[3] = measure(display);
+
+  for (size_t i = 0u; i < NUM_PHASES; ++i) {
+    results[i].time += marks[i + 1u].time - marks[i].time;
+    results[i].requests += marks[i + 1u].requests - marks[i].requests;
+  }
+
+  puglFreeView(view);
+  puglFreeWorld(world);
+}
+
+int
+main(int argc, char** argv)
+{
+  const size_t numRuns =
+    argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : (size_t)20u;
+
+  Measurement results[NUM_PHASES] = {{0.0, 0u}, {0.0, 0u}, {0.0, 0u}};
+  for (size_t i = 0u; i < numRuns; ++i) {
+    run(results);
+  }
+
+  printf("# Phase\tms\trequests\n");
+  for (size_t i = 0u; i < NUM_PHASES; ++i) {
+    printf("%s\t%.3f\t%.1f\n",
+           phaseNames[i],
+           results[i].time / (double)numRuns * 1000.0,
+           (double)results[i].requests / (double)numRuns);
+  }
+
+  return 0;
+}
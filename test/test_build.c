@@ -22,6 +22,7 @@
 
 #include "pugl/cairo.h" // IWYU pragma: keep
 #include "pugl/gl.h"    // IWYU pragma: keep
+#include "pugl/pixel.h" // IWYU pragma: keep
 #include "pugl/pugl.h"  // IWYU pragma: keep
 #include "pugl/stub.h"  // IWYU pragma: keep
 
@@ -22,6 +22,7 @@
 
 #include "pugl/cairo.hpp" // IWYU pragma: keep
 #include "pugl/gl.hpp"    // IWYU pragma: keep
+#include "pugl/pixel.hpp" // IWYU pragma: keep
 #include "pugl/pugl.h"    // IWYU pragma: keep
 #include "pugl/pugl.hpp"  // IWYU pragma: keep
 #include "pugl/stub.hpp"  // IWYU pragma: keep
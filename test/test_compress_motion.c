@@ -0,0 +1,182 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that consecutive motion events are merged with the compress motion
+  hint, without being reordered around other events, including key presses
+  that produce text.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <X11/X.h>
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAX_EVENTS 16u
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  PuglEvent       events[MAX_EVENTS];
+  size_t          numEvents;
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  if (event->type == PUGL_MOTION || event->type == PUGL_BUTTON_PRESS ||
+      event->type == PUGL_KEY_PRESS || event->type == PUGL_TEXT) {
+    assert(test->numEvents < MAX_EVENTS);
+    test->events[test->numEvents++] = *event;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static void
+queueEvents(PuglTest* test)
+{
+  Display* const display = (Display*)puglGetNativeWorld(test->world);
+  const Window   window  = (Window)puglGetNativeWindow(test->view);
+
+  // Seven motions, with a button press after the third and a key after five
+  static const int types[] = {MotionNotify,
+                              MotionNotify,
+                              MotionNotify,
+                              ButtonPress,
+                              MotionNotify,
+                              MotionNotify,
+                              KeyPress,
+                              MotionNotify,
+                              MotionNotify};
+
+  static const size_t numTypes = sizeof(types) / sizeof(types[0]);
+
+  // Events are put back at the front of the queue, so go in reverse order
+  for (size_t i = numTypes; i-- > 0;) {
+    XEvent xevent;
+    memset(&xevent, 0, sizeof(xevent));
+
+    if (types[i] == ButtonPress) {
+      xevent.xbutton.type    = ButtonPress;
+      xevent.xbutton.display = display;
+      xevent.xbutton.window  = window;
+      xevent.xbutton.time    = (Time)(1000u + i);
+      xevent.xbutton.button  = 1u;
+    } else if (types[i] == KeyPress) {
+      xevent.xkey.type    = KeyPress;
+      xevent.xkey.display = display;
+      xevent.xkey.window  = window;
+      xevent.xkey.time    = (Time)(1000u + i);
+      xevent.xkey.keycode = XKeysymToKeycode(display, XK_a);
+    } else {
+      xevent.xmotion.type    = MotionNotify;
+      xevent.xmotion.display = display;
+      xevent.xmotion.window  = window;
+      xevent.xmotion.time    = (Time)(1000u + i);
+      xevent.xmotion.x       = (int)i;
+      xevent.xmotion.y       = (int)i;
+    }
+
+    XPutBackEvent(display, &xevent);
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app;
+  memset(&app, 0, sizeof(app));
+
+  app.world = puglNewWorld(PUGL_PROGRAM, 0);
+  app.opts  = puglParseTestOptions(&argc, &argv);
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglStubBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 256, 256);
+  assert(!puglRealize(app.view));
+  assert(!puglUpdate(app.world, 0.0));
+
+  // Check that every motion is delivered by default
+  app.numEvents = 0u;
+  queueEvents(&app);
+  assert(!puglUpdate(app.world, 0.0));
+  assert(app.numEvents == 10u);
+  for (size_t i = 0u; i < app.numEvents; ++i) {
+    if (app.events[i].type == PUGL_MOTION) {
+      assert(app.events[i].motion.count == 1u);
+    }
+  }
+
+  // Enable compression and check that motion is merged around the presses
+  assert(!puglSetViewHint(app.view, PUGL_COMPRESS_MOTION, PUGL_TRUE));
+  app.numEvents = 0u;
+  queueEvents(&app);
+  assert(!puglUpdate(app.world, 0.0));
+  assert(app.numEvents == 6u);
+
+  const PuglEventMotion* const first = &app.events[0].motion;
+  assert(first->type == PUGL_MOTION);
+  assert(first->count == 3u);
+  assert((int)first->x == 2 && (int)first->y == 2);
+  assert(first->firstTime < first->time);
+
+  assert(app.events[1].type == PUGL_BUTTON_PRESS);
+
+  const PuglEventMotion* const middle = &app.events[2].motion;
+  assert(middle->type == PUGL_MOTION);
+  assert(middle->count == 2u);
+  assert((int)middle->x == 5 && (int)middle->y == 5);
+  assert(middle->firstTime < middle->time);
+
+  assert(app.events[3].type == PUGL_KEY_PRESS);
+  assert(app.events[4].type == PUGL_TEXT);
+  assert(app.events[4].text.character == 'a');
+
+  const PuglEventMotion* const last = &app.events[5].motion;
+  assert(last->type == PUGL_MOTION);
+  assert(last->count == 2u);
+  assert((int)last->x == 8 && (int)last->y == 8);
+  assert(last->firstTime < last->time);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
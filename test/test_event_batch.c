@@ -0,0 +1,167 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that input events are delivered together to a batch function in the
+  order they occurred, while configure and expose still go to the event
+  function.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <X11/X.h>
+#include <X11/Xlib.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NUM_MOTIONS 100u
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numBatches;
+  size_t          numMotions;
+  size_t          numExposes;
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  switch (event->type) {
+  case PUGL_CREATE:
+  case PUGL_DESTROY:
+  case PUGL_CONFIGURE:
+    break;
+  case PUGL_EXPOSE:
+    ++test->numExposes;
+    break;
+  default:
+    // Everything else should go to the batch function
+    assert(false);
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static PuglStatus
+onEvents(PuglView* view, const PuglEvent* events, size_t numEvents)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  assert(numEvents > 0u);
+  ++test->numBatches;
+
+  for (size_t i = 0u; i < numEvents; ++i) {
+    if (test->opts.verbose) {
+      printEvent(&events[i], "Batched: ", true);
+    }
+
+    assert(events[i].type != PUGL_CONFIGURE);
+    assert(events[i].type != PUGL_EXPOSE);
+
+    if (events[i].type == PUGL_MOTION) {
+      // Motions must arrive in order
+      assert((size_t)events[i].motion.x == test->numMotions);
+      ++test->numMotions;
+    }
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static void
+queueMotions(PuglTest* test, const size_t numMotions)
+{
+  Display* const display = (Display*)puglGetNativeWorld(test->world);
+  const Window   window  = (Window)puglGetNativeWindow(test->view);
+
+  // Events are put back at the front of the queue, so go in reverse order
+  for (size_t i = numMotions; i-- > 0;) {
+    XEvent xevent;
+    memset(&xevent, 0, sizeof(xevent));
+
+    xevent.xmotion.type    = MotionNotify;
+    xevent.xmotion.display = display;
+    xevent.xmotion.window  = window;
+    xevent.xmotion.time    = (Time)(1000u + i);
+    xevent.xmotion.x       = (int)i;
+    xevent.xmotion.y       = (int)i;
+
+    XPutBackEvent(display, &xevent);
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app;
+  memset(&app, 0, sizeof(app));
+
+  app.world = puglNewWorld(PUGL_PROGRAM, 0);
+  app.opts  = puglParseTestOptions(&argc, &argv);
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglStubBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  assert(!puglSetEventBatchFunc(app.view, onEvents));
+  puglSetDefaultSize(app.view, 256, 256);
+
+  // Create and show window and wait for the initial expose
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  while (!app.numExposes) {
+    assert(!puglUpdate(app.world, -1.0));
+  }
+
+  // Check that many motions in a single update arrive in a few large batches
+  app.numBatches = 0u;
+  queueMotions(&app, NUM_MOTIONS);
+  assert(!puglUpdate(app.world, 0.0));
+  assert(app.numMotions == NUM_MOTIONS);
+  assert(app.numBatches < NUM_MOTIONS / 8u);
+
+  // Check that more motions are still delivered after resetting the function
+  assert(!puglSetEventBatchFunc(app.view, NULL));
+  assert(!puglSetEventBatchFunc(app.view, onEvents));
+  app.numMotions = 0u;
+  queueMotions(&app, NUM_MOTIONS);
+  assert(!puglUpdate(app.world, 0.0));
+  assert(app.numMotions == NUM_MOTIONS);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
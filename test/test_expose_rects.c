@@ -0,0 +1,168 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that separate redisplay rectangles are kept apart in the damaged
+  region, that overlapping ones are merged, and that too many are simplified.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+  START,
+  EXPOSED,
+  POSTED,
+  CHECKED,
+} State;
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  State           state;
+  PuglRect        posted[16];
+  size_t          numPosted;
+  size_t          numRects;
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test  = (PuglTest*)puglGetHandle(view);
+  size_t    count = 0u;
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  switch (event->type) {
+  case PUGL_UPDATE:
+    if (test->state == EXPOSED) {
+      for (size_t i = 0u; i < test->numPosted; ++i) {
+        puglPostRedisplayRect(view, test->posted[i]);
+      }
+
+      test->state = POSTED;
+    }
+    break;
+
+  case PUGL_EXPOSE: {
+    const PuglRect* const rects = puglGetExposeRects(view, &count);
+    assert(rects && count > 0u);
+
+    // Every rectangle must be within the expose region
+    for (size_t i = 0u; i < count; ++i) {
+      assert(rects[i].x >= event->expose.x);
+      assert(rects[i].y >= event->expose.y);
+      assert(rects[i].x + rects[i].width <=
+             event->expose.x + event->expose.width);
+      assert(rects[i].y + rects[i].height <=
+             event->expose.y + event->expose.height);
+    }
+
+    if (test->state == START) {
+      test->state = EXPOSED;
+    } else if (test->state == POSTED) {
+      test->numRects = count;
+      test->state    = CHECKED;
+    }
+  } break;
+
+  default:
+    // Outside of an expose, there is no damage
+    assert(!puglGetExposeRects(view, &count) || count == 0u);
+    break;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static size_t
+postAndCheck(PuglTest* test)
+{
+  test->state = EXPOSED;
+  while (test->state != CHECKED) {
+    assert(!puglUpdate(test->world, -1.0));
+  }
+
+  return test->numRects;
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app = {puglNewWorld(PUGL_PROGRAM, 0),
+                  NULL,
+                  puglParseTestOptions(&argc, &argv),
+                  START,
+                  {{0, 0, 0, 0}},
+                  0u,
+                  0u};
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglStubBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 512, 512);
+
+  // Create and show window and wait for the initial expose
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  while (app.state != EXPOSED) {
+    assert(!puglUpdate(app.world, -1.0));
+  }
+
+  // Two small rectangles in opposite corners stay separate
+  const PuglRect topLeft     = {0, 0, 16, 16};
+  const PuglRect bottomRight = {496, 496, 16, 16};
+  app.posted[0]              = topLeft;
+  app.posted[1]              = bottomRight;
+  app.numPosted              = 2u;
+  assert(postAndCheck(&app) == 2u);
+
+  // Overlapping rectangles are merged
+  const PuglRect overlapping = {8, 8, 16, 16};
+  const PuglRect contained   = {2, 2, 4, 4};
+  app.posted[1]              = overlapping;
+  app.posted[2]              = contained;
+  app.numPosted              = 3u;
+  assert(postAndCheck(&app) == 1u);
+
+  // Many separate rectangles are simplified rather than all being kept
+  for (size_t i = 0u; i < 16u; ++i) {
+    const PuglRect rect = {(double)i * 32.0, (double)i * 32.0, 4, 4};
+    app.posted[i]       = rect;
+  }
+  app.numPosted = 16u;
+  assert(postAndCheck(&app) < 16u);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
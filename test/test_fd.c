@@ -0,0 +1,89 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that registered file descriptors wake up the event loop and call their
+  functions, and stop doing so once unregistered.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#undef NDEBUG
+
+#include "pugl/pugl.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <unistd.h>
+
+typedef struct {
+  int    fds[2];
+  size_t numReads;
+} PuglTest;
+
+static void
+onReadable(PuglWorld* world, int fd, PuglFdFlags flags, void* data)
+{
+  PuglTest* test = (PuglTest*)data;
+  char      c    = 0;
+
+  assert(puglGetWorldHandle(world) == test);
+  assert(fd == test->fds[0]);
+  assert(flags & PUGL_FD_READ);
+  assert(read(fd, &c, 1) == 1);
+  assert(c == 'p');
+
+  ++test->numReads;
+}
+
+int
+main(void)
+{
+  PuglTest   test  = {{-1, -1}, 0};
+  PuglWorld* world = puglNewWorld(PUGL_PROGRAM, 0);
+
+  puglSetWorldHandle(world, &test);
+  assert(!pipe(test.fds));
+
+  // Check that invalid registrations are rejected
+  assert(puglRegisterFd(world, -1, PUGL_FD_READ, onReadable, &test));
+  assert(puglRegisterFd(world, test.fds[0], 0, onReadable, &test));
+  assert(puglRegisterFd(world, test.fds[0], PUGL_FD_READ, NULL, &test));
+  assert(puglUnregisterFd(world, test.fds[0]) == PUGL_FAILURE);
+
+  // Register read end of the pipe and check that nothing happens yet
+  assert(!puglRegisterFd(world, test.fds[0], PUGL_FD_READ, onReadable, &test));
+  assert(!puglUpdate(world, 0.0));
+  assert(test.numReads == 0);
+
+  // Write to the pipe and check that a blocking update wakes up and reads it
+  assert(write(test.fds[1], "p", 1) == 1);
+  assert(!puglUpdate(world, -1.0));
+  assert(test.numReads == 1);
+
+  // Unregister and check that writing no longer calls the function
+  assert(!puglUnregisterFd(world, test.fds[0]));
+  assert(write(test.fds[1], "p", 1) == 1);
+  assert(!puglUpdate(world, 0.01));
+  assert(test.numReads == 1);
+
+  // Tear down
+  puglFreeWorld(world);
+  close(test.fds[0]);
+  close(test.fds[1]);
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that frames drawn while capturing are all delivered in order, some
+  while drawing continues and the rest when capture is stopped.
+
+  This uses a headless view so that it runs without an X server.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/gl.h"
+#include "pugl/pugl.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NUM_FRAMES 10u
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numExposes;
+  size_t          numCaptures;
+  double          lastTime;
+} PuglTest;
+
+static unsigned
+frameShade(const size_t index)
+{
+  return (unsigned)(index * 16u);
+}
+
+static void
+onCapture(PuglView* view, const PuglGlFrame* frame)
+{
+  PuglTest* const test = (PuglTest*)puglGetHandle(view);
+
+  assert(frame->width == 64u);
+  assert(frame->height == 32u);
+  assert(frame->stride >= frame->width * 4u);
+  assert(frame->time >= test->lastTime);
+
+  // Every pixel has the shade of the frame, so frames are in order
+  const uint8_t* const pixels   = (const uint8_t*)frame->pixels;
+  const uint8_t* const lastRow  = pixels + (frame->height - 1u) * frame->stride;
+  const unsigned       expected = frameShade(test->numCaptures);
+
+  assert(pixels[0] == expected);
+  assert(lastRow[(frame->width - 1u) * 4u] == expected);
+  assert(pixels[1] == 0u && pixels[2] == 0xFFu);
+
+  test->lastTime = frame->time;
+  ++test->numCaptures;
+}
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* const test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  if (event->type == PUGL_CONFIGURE) {
+    glViewport(0, 0, (int)event->configure.width, (int)event->configure.height);
+  } else if (event->type == PUGL_EXPOSE) {
+    const unsigned shade = frameShade(test->numExposes);
+    const float    red   = (float)shade / 255.0f;
+
+    glClearColor(red, 0.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ++test->numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app = {puglNewWorld(PUGL_PROGRAM, PUGL_WORLD_HEADLESS),
+                  NULL,
+                  puglParseTestOptions(&argc, &argv),
+                  0u,
+                  0u,
+                  0.0};
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglEglBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 64, 32);
+
+  // Capture can only be started for a realized view, and stopped if started
+  assert(puglStartCapture(app.view, onCapture) == PUGL_FAILURE);
+  assert(!puglRealize(app.view));
+  assert(puglStopCapture(app.view) == PUGL_FAILURE);
+  assert(!puglStartCapture(app.view, onCapture));
+
+  // Draw frames, some of which should be delivered while drawing
+  assert(!puglShow(app.view));
+  while (app.numExposes < NUM_FRAMES) {
+    assert(!puglPostRedisplay(app.view));
+    assert(!puglUpdate(app.world, 0.0));
+  }
+
+  assert(app.numCaptures > 0u);
+  assert(app.numCaptures < NUM_FRAMES);
+
+  // Stop capture, which delivers the remaining frames
+  assert(!puglStopCapture(app.view));
+  assert(app.numCaptures == NUM_FRAMES);
+
+  // Frames drawn after stopping aren't captured
+  assert(!puglPostRedisplay(app.view));
+  assert(!puglUpdate(app.world, 0.0));
+  assert(app.numExposes == NUM_FRAMES + 1u);
+  assert(app.numCaptures == NUM_FRAMES);
+
+  // Capturing again and freeing the view drops frames without delivering them
+  assert(!puglStartCapture(app.view, onCapture));
+  assert(!puglPostRedisplay(app.view));
+  assert(!puglUpdate(app.world, 0.0));
+  puglFreeView(app.view);
+  assert(app.numCaptures == NUM_FRAMES);
+
+  puglFreeWorld(app.world);
+
+  return 0;
+}
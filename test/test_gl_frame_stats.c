@@ -0,0 +1,146 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that presentation statistics count every frame drawn to a view, are
+  only available when the world collects statistics, and don't count time
+  spent idle between frames as missed retraces.
+
+  This uses a headless view so that it runs without an X server, where times
+  come from the clock rather than the display.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/gl.h"
+#include "pugl/pugl.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NUM_FRAMES 5u
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numExposes;
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* const test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  if (event->type == PUGL_EXPOSE) {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ++test->numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static PuglView*
+makeView(PuglTest* const test)
+{
+  PuglView* const view = puglNewView(test->world);
+
+  puglSetBackend(view, puglEglBackend());
+  puglSetHandle(view, test);
+  puglSetEventFunc(view, onEvent);
+  puglSetDefaultSize(view, 64, 64);
+  puglSetViewHint(view, PUGL_REFRESH_RATE, 60);
+  puglSetViewHint(view, PUGL_SWAP_INTERVAL, 1);
+
+  return view;
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest         app   = {NULL, NULL, puglParseTestOptions(&argc, &argv), 0u};
+  PuglGlFrameStats stats = {0u, 0.0, 0, 0, 0u, false, {0u}};
+
+  // Statistics aren't available without the stats flag
+  app.world = puglNewWorld(PUGL_PROGRAM, PUGL_WORLD_HEADLESS);
+  app.view  = makeView(&app);
+  assert(!puglRealize(app.view));
+  assert(puglGetFrameStats(app.view, &stats) == PUGL_FAILURE);
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  // Set up a view in a world that collects statistics
+  const PuglWorldFlags flags = PUGL_WORLD_HEADLESS | PUGL_WORLD_STATS;
+  app.world                  = puglNewWorld(PUGL_PROGRAM, flags);
+  app.view  = makeView(&app);
+  assert(puglGetFrameStats(app.view, &stats) == PUGL_FAILURE);
+  assert(!puglRealize(app.view));
+  assert(!puglGetFrameStats(app.view, &stats));
+  assert(stats.numFrames == 0u);
+
+  // Draw some frames
+  assert(!puglShow(app.view));
+  while (app.numExposes < NUM_FRAMES) {
+    assert(!puglPostRedisplay(app.view));
+    assert(!puglUpdate(app.world, 0.0));
+  }
+
+  // Check that every frame was counted, with an interval between each
+  assert(!puglGetFrameStats(app.view, &stats));
+  assert(stats.numFrames == NUM_FRAMES);
+  assert(stats.lastPresentTime > 0.0);
+  assert(stats.lastPresentTime <= puglGetTime(app.world));
+  assert(!stats.precise);
+  assert(stats.lastMsc == 0 && stats.lastSbc == 0);
+  assert(stats.missedVblanks == 0u);
+
+  uint64_t numIntervals = 0u;
+  for (size_t i = 0u; i < PUGL_GL_NUM_INTERVALS; ++i) {
+    numIntervals += stats.intervals[i];
+  }
+
+  assert(numIntervals == NUM_FRAMES - 1u);
+
+  // Wait for several retraces without drawing, then draw another frame
+  const double idleStart = puglGetTime(app.world);
+  while (puglGetTime(app.world) - idleStart < 0.1) {
+    assert(!puglUpdate(app.world, 0.1));
+  }
+
+  assert(!puglPostRedisplay(app.view));
+  while (app.numExposes < NUM_FRAMES + 1u) {
+    assert(!puglUpdate(app.world, 0.0));
+  }
+
+  // Check that the frame was counted, but the idle time wasn't missed
+  assert(!puglGetFrameStats(app.view, &stats));
+  assert(stats.numFrames == NUM_FRAMES + 1u);
+  assert(stats.missedVblanks == 0u);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
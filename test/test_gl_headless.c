@@ -0,0 +1,216 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that a view in a headless world is drawn offscreen with no X server,
+  and that the pixels it draws can be read back, also after it is resized,
+  without disturbing the pixel pack state of the application.  Also checks
+  that a trace recorded from the view can be replayed.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/gl.h"
+#include "pugl/pugl.h"
+
+#include <GL/glext.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numConfigures;
+  size_t          numExposes;
+} PuglTest;
+
+static const char* const tracePath = "test_gl_headless.trace";
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  switch (event->type) {
+  case PUGL_CONFIGURE:
+    glViewport(0, 0, (int)event->configure.width, (int)event->configure.height);
+    ++test->numConfigures;
+    break;
+
+  case PUGL_EXPOSE:
+    // Clear to red, with a green square in the top left corner
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, (int)puglGetFrame(view).height - 8, 8, 8);
+    glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+    ++test->numExposes;
+    break;
+
+  default:
+    break;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static void
+checkPixels(PuglView* const view, const size_t width, const size_t height)
+{
+  const size_t   stride = width * 4u + 16u;
+  uint8_t* const pixels = (uint8_t*)calloc(stride, height);
+
+  const PFNGLGENBUFFERSPROC genBuffers =
+    (PFNGLGENBUFFERSPROC)puglGetProcAddress("glGenBuffers");
+  const PFNGLDELETEBUFFERSPROC deleteBuffers =
+    (PFNGLDELETEBUFFERSPROC)puglGetProcAddress("glDeleteBuffers");
+  const PFNGLBINDBUFFERPROC bindBuffer =
+    (PFNGLBINDBUFFERPROC)puglGetProcAddress("glBindBuffer");
+
+  assert(genBuffers && deleteBuffers && bindBuffer);
+
+  // Set up pack state like an application that is reading pixels itself
+  GLuint buffer = 0u;
+  assert(!puglEnterContext(view));
+  genBuffers(1, &buffer);
+  bindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 8);
+  glPixelStorei(GL_PACK_ROW_LENGTH, 3);
+  assert(!puglLeaveContext(view));
+
+  assert(puglReadPixels(view, pixels, width * 4u - 1u) == PUGL_FAILURE);
+  assert(puglReadPixels(view, pixels, width * 4u + 2u) == PUGL_FAILURE);
+  assert(!puglReadPixels(view, pixels, stride));
+
+  // Check that the pack state was left alone
+  GLint packBuffer    = 0;
+  GLint packAlignment = 0;
+  GLint packRowLength = 0;
+  assert(!puglEnterContext(view));
+  glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+  glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+  glGetIntegerv(GL_PACK_ROW_LENGTH, &packRowLength);
+  bindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+  deleteBuffers(1, &buffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+  assert(!puglLeaveContext(view));
+
+  assert(packBuffer == (GLint)buffer);
+  assert(packAlignment == 8);
+  assert(packRowLength == 3);
+
+  for (size_t y = 0u; y < height; ++y) {
+    for (size_t x = 0u; x < width; ++x) {
+      const uint8_t* const pixel  = pixels + y * stride + x * 4u;
+      const bool           corner = x < 8u && y < 8u;
+
+      assert(pixel[0] == (corner ? 0x00 : 0xFF));
+      assert(pixel[1] == (corner ? 0xFF : 0x00));
+      assert(pixel[2] == 0x00);
+    }
+  }
+
+  free(pixels);
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app = {puglNewWorld(PUGL_PROGRAM, PUGL_WORLD_HEADLESS),
+                  NULL,
+                  puglParseTestOptions(&argc, &argv),
+                  0u,
+                  0u};
+
+  assert(app.world);
+  assert(!puglGetNativeWorld(app.world));
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglEglBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 64, 48);
+  puglSetViewHint(app.view, PUGL_DOUBLE_BUFFER, PUGL_TRUE);
+
+  // Nothing can be read from an unrealized view
+  uint8_t pixel[4] = {0u, 0u, 0u, 0u};
+  assert(puglReadPixels(app.view, pixel, 0u) == PUGL_FAILURE);
+
+  // Realize the view, which has no window and is always single buffered
+  assert(!puglRealize(app.view));
+  assert(!puglGetNativeWindow(app.view));
+  assert(puglGetViewHint(app.view, PUGL_DOUBLE_BUFFER) == PUGL_FALSE);
+
+  // Show the view and wait for it to be drawn, which must not block
+  assert(!puglShow(app.view));
+  assert(puglGetVisible(app.view));
+  while (!app.numExposes) {
+    assert(!puglUpdate(app.world, -1.0));
+  }
+
+  assert(app.numConfigures == 1u);
+  checkPixels(app.view, 64u, 48u);
+
+  // Resize the view and check that the new size is drawn
+  const PuglRect frame = {0, 0, 32, 80};
+  assert(!puglStartRecording(app.world, tracePath));
+  assert(!puglSetFrame(app.view, frame));
+  while (app.numExposes < 2u) {
+    assert(!puglUpdate(app.world, -1.0));
+  }
+
+  assert(!puglStopRecording(app.world));
+  assert(app.numConfigures == 2u);
+  checkPixels(app.view, 32u, 80u);
+
+  // Replay the resize, which redraws but doesn't configure the same size
+  assert(!puglReplay(app.world, tracePath, 0u));
+  assert(app.numConfigures == 2u);
+  assert(app.numExposes == 3u);
+  checkPixels(app.view, 32u, 80u);
+  assert(!remove(tracePath));
+
+  // Hidden views aren't redrawn
+  assert(!puglHide(app.view));
+  assert(!puglGetVisible(app.view));
+  assert(!puglPostRedisplay(app.view));
+  assert(!puglUpdate(app.world, 0.0));
+  assert(app.numExposes == 3u);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
@@ -15,7 +15,10 @@
 */
 
 /*
-  Tests that all hints are set to real values after a view is realized.
+  Tests that all hints are set to real values after a view is realized, and
+  that views with the same hints get the same configuration.
+
+  This is built for both GLX and EGL on X11, since both must behave the same.
 */
 
 #undef NDEBUG
@@ -26,6 +29,26 @@
 #include "pugl/pugl.h"
 
 #include <assert.h>
+#include <stddef.h>
+
+static const PuglViewHint configHints[] = {PUGL_RED_BITS,
+                                           PUGL_GREEN_BITS,
+                                           PUGL_BLUE_BITS,
+                                           PUGL_ALPHA_BITS,
+                                           PUGL_DEPTH_BITS,
+                                           PUGL_STENCIL_BITS,
+                                           PUGL_SAMPLES,
+                                           PUGL_DOUBLE_BUFFER};
+
+static const PuglBackend*
+backend(void)
+{
+#ifdef PUGL_TEST_EGL
+  return puglEglBackend();
+#else
+  return puglGlBackend();
+#endif
+}
 
 static PuglStatus
 onEvent(PuglView* view, const PuglEvent* event)
@@ -44,7 +67,7 @@ main(void)
 
   // Set up view
   puglSetClassName(world, "Pugl Test");
-  puglSetBackend(view, puglGlBackend());
+  puglSetBackend(view, backend());
   puglSetEventFunc(view, onEvent);
   puglSetDefaultSize(view, 512, 512);
 
@@ -81,7 +104,23 @@ main(void)
   assert(puglGetViewHint(view, PUGL_IGNORE_KEY_REPEAT) != PUGL_DONT_CARE);
   assert(puglGetViewHint(view, PUGL_REFRESH_RATE) != PUGL_DONT_CARE);
 
+  // Check that a second view with the same hints gets the same configuration
+  PuglView* const other = puglNewView(world);
+  puglSetBackend(other, backend());
+  puglSetEventFunc(other, onEvent);
+  puglSetDefaultSize(other, 256, 256);
+  for (size_t i = 0u; i < sizeof(configHints) / sizeof(configHints[0]); ++i) {
+    assert(!puglSetViewHint(other, configHints[i], PUGL_DONT_CARE));
+  }
+
+  assert(!puglRealize(other));
+  for (size_t i = 0u; i < sizeof(configHints) / sizeof(configHints[0]); ++i) {
+    assert(puglGetViewHint(other, configHints[i]) ==
+           puglGetViewHint(view, configHints[i]));
+  }
+
   // Tear down
+  puglFreeView(other);
   puglFreeView(view);
   puglFreeWorld(world);
 
@@ -0,0 +1,143 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that with the retain contents hint, a GL view gets an expose for at
+  least the posted region, and that drawing is clipped to the damaged region.
+
+  This is built for both GLX and EGL on X11, since both must behave the same.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/gl.h"
+#include "pugl/pugl.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numExposes;
+  PuglEventExpose lastExpose;
+} PuglTest;
+
+static const PuglBackend*
+backend(void)
+{
+#ifdef PUGL_TEST_EGL
+  return puglEglBackend();
+#else
+  return puglGlBackend();
+#endif
+}
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  if (event->type == PUGL_EXPOSE) {
+    const PuglEventExpose* const expose = &event->expose;
+
+    // Every damaged rectangle must be within the expose
+    size_t                count = 0u;
+    const PuglRect* const rects = puglGetExposeRects(view, &count);
+    for (size_t i = 0u; i < count; ++i) {
+      assert(rects[i].x >= expose->x && rects[i].y >= expose->y);
+      assert(rects[i].x + rects[i].width <= expose->x + expose->width);
+      assert(rects[i].y + rects[i].height <= expose->y + expose->height);
+    }
+
+    // If drawing is clipped, then the whole expose must be drawable
+    if (glIsEnabled(GL_SCISSOR_TEST)) {
+      const double height = puglGetFrame(view).height;
+      GLint        box[4] = {0, 0, 0, 0};
+
+      glGetIntegerv(GL_SCISSOR_BOX, box);
+      assert(box[0] <= (GLint)expose->x);
+      assert(box[1] <= (GLint)(height - expose->y - expose->height));
+      assert(box[0] + box[2] >= (GLint)(expose->x + expose->width));
+      assert(box[1] + box[3] >= (GLint)(height - expose->y));
+    }
+
+    glClearColor(0.25f, 0.5f, 0.75f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    test->lastExpose = *expose;
+    ++test->numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static void
+waitForExpose(PuglTest* test)
+{
+  test->numExposes = 0u;
+  while (!test->numExposes) {
+    assert(!puglUpdate(test->world, -1.0));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app = {puglNewWorld(PUGL_PROGRAM, 0),
+                  NULL,
+                  puglParseTestOptions(&argc, &argv),
+                  0u,
+                  {PUGL_NOTHING, 0u, 0.0, 0.0, 0.0, 0.0}};
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, backend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 256, 256);
+  puglSetViewHint(app.view, PUGL_RETAIN_CONTENTS, PUGL_TRUE);
+
+  // Create and show window and wait for the initial expose
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  waitForExpose(&app);
+
+  // Check that several small redisplays are each exposed
+  for (int i = 0; i < 8; ++i) {
+    const PuglRect rect = {8.0 * i, 16.0, 4.0, 4.0};
+    assert(!puglPostRedisplayRect(app.view, rect));
+    waitForExpose(&app);
+
+    assert(app.lastExpose.x <= rect.x && app.lastExpose.y <= rect.y);
+    assert(app.lastExpose.x + app.lastExpose.width >= rect.x + rect.width);
+    assert(app.lastExpose.y + app.lastExpose.height >= rect.y + rect.height);
+  }
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that views with the share context hint can use objects created by
+  other views in the same world, even after those views are freed.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/gl.h"
+#include "pugl/pugl.h"
+
+#include <assert.h>
+#include <stdbool.h>
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  (void)view;
+  (void)event;
+
+  return PUGL_SUCCESS;
+}
+
+static PuglView*
+makeView(PuglWorld* const world, const bool share)
+{
+  PuglView* const view = puglNewView(world);
+
+  puglSetBackend(view, puglGlBackend());
+  puglSetEventFunc(view, onEvent);
+  puglSetDefaultSize(view, 64, 64);
+  assert(!puglSetViewHint(view, PUGL_SHARE_CONTEXT, share));
+  assert(!puglRealize(view));
+
+  return view;
+}
+
+static bool
+hasTexture(PuglView* const view, const GLuint texture)
+{
+  assert(!puglEnterContext(view));
+  const bool result = glIsTexture(texture);
+  assert(!puglLeaveContext(view));
+
+  return result;
+}
+
+int
+main(void)
+{
+  PuglWorld* const world = puglNewWorld(PUGL_PROGRAM, 0);
+  puglSetClassName(world, "Pugl Test");
+
+  // Views don't share by default
+  PuglView* const separate = makeView(world, false);
+  assert(puglGetViewHint(separate, PUGL_SHARE_CONTEXT) == PUGL_FALSE);
+
+  // Create a texture in the context of a sharing view
+  PuglView* const first   = makeView(world, true);
+  GLuint          texture = 0;
+  if (puglGetViewHint(first, PUGL_SHARE_CONTEXT) == PUGL_FALSE) {
+    // Sharing isn't supported here, so there's nothing more to test
+    puglFreeView(first);
+    puglFreeView(separate);
+    puglFreeWorld(world);
+    return 0;
+  }
+
+  assert(!puglEnterContext(first));
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  assert(!puglLeaveContext(first));
+  assert(hasTexture(first, texture));
+
+  // Check that the texture is only visible to sharing views
+  PuglView* const second = makeView(world, true);
+  assert(puglGetViewHint(second, PUGL_SHARE_CONTEXT) == PUGL_TRUE);
+  assert(hasTexture(second, texture));
+  assert(!hasTexture(separate, texture));
+
+  // Check that the texture outlives the views that have used it
+  puglFreeView(first);
+  puglFreeView(second);
+
+  PuglView* const third = makeView(world, true);
+  assert(hasTexture(third, texture));
+
+  // Tear down
+  puglFreeView(third);
+  puglFreeView(separate);
+  puglFreeWorld(world);
+
+  return 0;
+}
@@ -0,0 +1,167 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that many timers with different periods can run at once, that each
+  fires at its own rate, and that stopped timers and the timers of freed views
+  no longer fire.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define NUM_TIMERS 1000u
+
+static const double duration = 0.25;
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglView*       otherView;
+  PuglTestOptions opts;
+  size_t          counts[NUM_TIMERS];
+  size_t          numOtherAlarms;
+} PuglTest;
+
+static double
+timerPeriod(const uintptr_t id)
+{
+  // Spread periods between 10 and 100 milliseconds
+  return 0.010 + (double)(id % 10u) * 0.010;
+}
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  if (event->type == PUGL_TIMER) {
+    if (view == test->otherView) {
+      ++test->numOtherAlarms;
+    } else {
+      assert(event->timer.id < NUM_TIMERS);
+      ++test->counts[event->timer.id];
+    }
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static PuglView*
+makeView(PuglTest* test)
+{
+  PuglView* view = puglNewView(test->world);
+
+  puglSetBackend(view, puglStubBackend());
+  puglSetHandle(view, test);
+  puglSetEventFunc(view, onEvent);
+  puglSetDefaultSize(view, 64, 64);
+  assert(!puglRealize(view));
+
+  return view;
+}
+
+static void
+resetCounts(PuglTest* test)
+{
+  for (size_t i = 0u; i < NUM_TIMERS; ++i) {
+    test->counts[i] = 0u;
+  }
+
+  test->numOtherAlarms = 0u;
+}
+
+static void
+update(PuglTest* test, const double seconds)
+{
+  const double endTime = puglGetTime(test->world) + seconds;
+  while (puglGetTime(test->world) < endTime) {
+    assert(!puglUpdate(test->world, endTime - puglGetTime(test->world)));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  static PuglTest app;
+
+  app.world = puglNewWorld(PUGL_PROGRAM, 0);
+  app.opts  = puglParseTestOptions(&argc, &argv);
+
+  puglSetClassName(app.world, "Pugl Test");
+  app.view      = makeView(&app);
+  app.otherView = makeView(&app);
+
+  // Start many timers on one view, and one on another
+  for (uintptr_t id = 0u; id < NUM_TIMERS; ++id) {
+    assert(!puglStartTimer(app.view, id, timerPeriod(id)));
+  }
+
+  assert(!puglStartTimer(app.otherView, 0u, 0.01));
+
+  // Check that every timer fired about as many times as it should have
+  update(&app, duration);
+  for (uintptr_t id = 0u; id < NUM_TIMERS; ++id) {
+    const double expected = duration / timerPeriod(id);
+    const double actual   = (double)app.counts[id];
+    if (actual < expected - 2.0 || actual > expected + 1.0) {
+      fprintf(stderr,
+              "error: Timer %u fired %u times\n",
+              (unsigned)id,
+              (unsigned)app.counts[id]);
+    }
+
+    assert(actual >= expected - 2.0 && actual <= expected + 1.0);
+  }
+
+  assert(app.numOtherAlarms > 0u);
+
+  // Stop every even timer and free the other view with its timer still active
+  for (uintptr_t id = 0u; id < NUM_TIMERS; id += 2u) {
+    assert(!puglStopTimer(app.view, id));
+  }
+
+  assert(puglStopTimer(app.view, 0u) == PUGL_FAILURE);
+  puglFreeView(app.otherView);
+  app.otherView = NULL;
+
+  // Check that only the remaining timers still fire
+  resetCounts(&app);
+  update(&app, duration);
+  for (uintptr_t id = 0u; id < NUM_TIMERS; ++id) {
+    assert((id % 2u) ? app.counts[id] > 0u : app.counts[id] == 0u);
+  }
+
+  assert(app.numOtherAlarms == 0u);
+
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that the pixel backend provides a buffer covering the view only while
+  drawing, and that it follows the view size.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pixel.h"
+#include "pugl/pugl.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numExposes;
+  unsigned        width;
+  unsigned        height;
+} PuglTest;
+
+static unsigned
+minU(const unsigned a, const unsigned b)
+{
+  return a < b ? a : b;
+}
+
+static void
+fillRect(const PuglPixelBuffer* buffer, const PuglRect* rect)
+{
+  // Clamp to the buffer, since the view may have been resized since
+  const unsigned x0 = (unsigned)rect->x;
+  const unsigned y0 = (unsigned)rect->y;
+  const unsigned x1 = minU(x0 + (unsigned)rect->width, buffer->width);
+  const unsigned y1 = minU(y0 + (unsigned)rect->height, buffer->height);
+
+  for (unsigned y = y0; y < y1; ++y) {
+    void* const     start = (uint8_t*)buffer->data + (size_t)y * buffer->stride;
+    uint32_t* const row   = (uint32_t*)start;
+
+    for (unsigned x = x0; x < x1; ++x) {
+      row[x] = 0xFF4080C0u;
+    }
+  }
+}
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  if (event->type == PUGL_EXPOSE) {
+    const PuglPixelBuffer* const buffer =
+      (const PuglPixelBuffer*)puglGetContext(view);
+
+    assert(buffer && buffer->data);
+    assert(buffer->stride >= buffer->width * 4u);
+    assert(buffer->format == PUGL_PIXEL_XRGB32 ||
+           buffer->format == PUGL_PIXEL_ARGB32);
+
+    // Draw every damaged rectangle
+    size_t                count = 0u;
+    const PuglRect* const rects = puglGetExposeRects(view, &count);
+    for (size_t i = 0u; i < count; ++i) {
+      fillRect(buffer, &rects[i]);
+    }
+
+    test->width  = buffer->width;
+    test->height = buffer->height;
+    ++test->numExposes;
+  } else if (event->type != PUGL_CREATE && event->type != PUGL_DESTROY) {
+    // The buffer is only available while drawing
+    assert(!puglGetContext(view));
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static void
+waitForExpose(PuglTest* test)
+{
+  const size_t numExposes = test->numExposes;
+  while (test->numExposes == numExposes) {
+    assert(!puglUpdate(test->world, -1.0));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app = {puglNewWorld(PUGL_PROGRAM, 0),
+                  NULL,
+                  puglParseTestOptions(&argc, &argv),
+                  0u,
+                  0u,
+                  0u};
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglPixelBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 256, 128);
+
+  // Create and show window and wait for the initial expose
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  waitForExpose(&app);
+  assert(app.width == 256u && app.height == 128u);
+
+  // Redraw a small area
+  const PuglRect rect = {16, 16, 32, 32};
+  assert(!puglPostRedisplayRect(app.view, rect));
+  waitForExpose(&app);
+  assert(app.width == 256u && app.height == 128u);
+
+  // Resize and check that the buffer is resized with the view
+  const PuglRect frame = puglGetFrame(app.view);
+  const PuglRect large = {frame.x, frame.y, 320, 240};
+  assert(!puglSetFrame(app.view, large));
+  assert(!puglPostRedisplay(app.view));
+  while (app.width != 320u || app.height != 240u) {
+    waitForExpose(&app);
+  }
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that events can be recorded to a trace, and that replaying the trace
+  dispatches the same events again.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __APPLE__
+static const double timeout = 1 / 60.0;
+#else
+static const double timeout = -1.0;
+#endif
+
+static const char* const tracePath = "test_record.trace";
+
+static const PuglRect redisplayRect = {2, 4, 8, 16};
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numExposes;
+  PuglRect        lastExpose;
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  if (event->type == PUGL_EXPOSE) {
+    const PuglRect rect = {event->expose.x,
+                           event->expose.y,
+                           event->expose.width,
+                           event->expose.height};
+
+    ++test->numExposes;
+    test->lastExpose = rect;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static bool
+isRedisplayRect(const PuglRect rect)
+{
+  return (int)rect.x == (int)redisplayRect.x &&
+         (int)rect.y == (int)redisplayRect.y &&
+         (int)rect.width == (int)redisplayRect.width &&
+         (int)rect.height == (int)redisplayRect.height;
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app;
+  memset(&app, 0, sizeof(app));
+
+  app.world = puglNewWorld(PUGL_PROGRAM, 0);
+  app.opts  = puglParseTestOptions(&argc, &argv);
+
+  // Check that invalid recording calls fail
+  assert(puglStopRecording(app.world) == PUGL_FAILURE);
+  assert(puglStartRecording(app.world, "/nonexistent/dir/trace"));
+  assert(puglReplay(app.world, "/nonexistent/dir/trace", 0u));
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglStubBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 256, 256);
+
+  // Record showing the window and a redisplay
+  assert(!puglStartRecording(app.world, tracePath));
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  while (!app.numExposes) {
+    assert(!puglUpdate(app.world, timeout));
+  }
+
+  assert(!puglPostRedisplayRect(app.view, redisplayRect));
+  while (!isRedisplayRect(app.lastExpose)) {
+    assert(!puglUpdate(app.world, timeout));
+  }
+
+  const size_t numRecordedExposes = app.numExposes;
+  assert(!puglStopRecording(app.world));
+
+  // Replay as fast as possible and check that the same exposes happen
+  app.numExposes = 0u;
+  memset(&app.lastExpose, 0, sizeof(app.lastExpose));
+  assert(!puglReplay(app.world, tracePath, 0u));
+  assert(app.numExposes == numRecordedExposes);
+  assert(isRedisplayRect(app.lastExpose));
+
+  // Replay again with the original timing
+  app.numExposes = 0u;
+  assert(!puglReplay(app.world, tracePath, PUGL_REPLAY_REAL_TIME));
+  assert(app.numExposes >= numRecordedExposes);
+
+  // Check that a file that isn't a trace is rejected
+  FILE* const file = fopen(tracePath, "wb");
+  assert(file);
+  assert(fputs("Not a trace\n", file) >= 0);
+  assert(!fclose(file));
+  assert(puglReplay(app.world, tracePath, 0u) == PUGL_BAD_PARAMETER);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+  assert(!remove(tracePath));
+
+  return 0;
+}
@@ -0,0 +1,139 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that with the retain contents hint, system exposes are restored
+  without the application drawing, until the contents are lost on resize.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/cairo.h"
+#include "pugl/pugl.h"
+
+#include <X11/X.h>
+#include <X11/Xlib.h>
+#include <cairo.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numExposes;
+  PuglEventExpose lastExpose;
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  if (event->type == PUGL_EXPOSE) {
+    cairo_t* const cr = (cairo_t*)puglGetContext(view);
+
+    cairo_set_source_rgb(cr, 0.25, 0.5, 0.75);
+    cairo_paint(cr);
+
+    test->lastExpose = event->expose;
+    ++test->numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static void
+putSystemExpose(PuglTest* test)
+{
+  XEvent xevent;
+  memset(&xevent, 0, sizeof(xevent));
+
+  xevent.xexpose.type    = Expose;
+  xevent.xexpose.display = (Display*)puglGetNativeWorld(test->world);
+  xevent.xexpose.window  = (Window)puglGetNativeWindow(test->view);
+  xevent.xexpose.x       = 16;
+  xevent.xexpose.y       = 16;
+  xevent.xexpose.width   = 32;
+  xevent.xexpose.height  = 32;
+
+  XPutBackEvent(xevent.xexpose.display, &xevent);
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app;
+  memset(&app, 0, sizeof(app));
+
+  app.world = puglNewWorld(PUGL_PROGRAM, 0);
+  app.opts  = puglParseTestOptions(&argc, &argv);
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglCairoBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 256, 256);
+  puglSetViewHint(app.view, PUGL_RETAIN_CONTENTS, PUGL_TRUE);
+
+  // Create and show window and wait for the initial expose of everything
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  while (!app.numExposes) {
+    assert(!puglUpdate(app.world, -1.0));
+  }
+
+  // Check that a system expose is restored without the application drawing
+  app.numExposes = 0u;
+  putSystemExpose(&app);
+  assert(!puglUpdate(app.world, 0.0));
+  assert(app.numExposes == 0u);
+
+  // Check that the application still draws its own redisplays
+  const PuglRect rect = {8, 8, 4, 4};
+  assert(!puglPostRedisplayRect(app.view, rect));
+  while (!app.numExposes) {
+    assert(!puglUpdate(app.world, -1.0));
+  }
+
+  assert((int)app.lastExpose.x == 8 && (int)app.lastExpose.y == 8);
+  assert((int)app.lastExpose.width == 4 && (int)app.lastExpose.height == 4);
+
+  // Resize, which loses the contents, so a system expose must be drawn
+  const PuglRect frame = puglGetFrame(app.view);
+  const PuglRect large = {frame.x, frame.y, 320, 320};
+  assert(!puglSetFrame(app.view, large));
+  app.numExposes = 0u;
+  putSystemExpose(&app);
+  assert(!puglUpdate(app.world, 0.0));
+  assert(app.numExposes == 1u);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
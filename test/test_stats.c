@@ -0,0 +1,140 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that statistics are only available when enabled, and that they count
+  the events that are dispatched.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __APPLE__
+static const double timeout = 1 / 60.0;
+#else
+static const double timeout = -1.0;
+#endif
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numEvents;
+  size_t          numExposes;
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  ++test->numEvents;
+  if (event->type == PUGL_EXPOSE) {
+    ++test->numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static PuglView*
+makeView(PuglTest* test)
+{
+  PuglView* view = puglNewView(test->world);
+
+  puglSetBackend(view, puglStubBackend());
+  puglSetHandle(view, test);
+  puglSetEventFunc(view, onEvent);
+  puglSetDefaultSize(view, 256, 256);
+
+  return view;
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest       app;
+  PuglWorldStats worldStats;
+  PuglViewStats  viewStats;
+
+  memset(&app, 0, sizeof(app));
+  app.opts = puglParseTestOptions(&argc, &argv);
+
+  // Check that statistics aren't available by default
+  app.world = puglNewWorld(PUGL_PROGRAM, 0);
+  app.view  = makeView(&app);
+  assert(puglGetWorldStats(app.world, &worldStats) == PUGL_FAILURE);
+  assert(puglGetViewStats(app.view, &viewStats) == PUGL_FAILURE);
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  // Set up a world with statistics and check that they start at zero
+  app.world = puglNewWorld(PUGL_PROGRAM, PUGL_WORLD_STATS);
+  app.view  = makeView(&app);
+  puglSetClassName(app.world, "Pugl Test");
+  assert(!puglGetWorldStats(app.world, &worldStats));
+  assert(!puglGetViewStats(app.view, &viewStats));
+  assert(worldStats.numUpdates == 0u);
+  assert(worldStats.numEvents == 0u);
+  assert(viewStats.numExposes == 0u);
+
+  // Create and show window and wait for the initial expose
+  app.numEvents = 0u;
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  size_t numUpdates = 0u;
+  while (!app.numExposes) {
+    assert(!puglUpdate(app.world, timeout));
+    ++numUpdates;
+  }
+
+  // Check that every event and update was counted
+  assert(!puglGetWorldStats(app.world, &worldStats));
+  assert(!puglGetViewStats(app.view, &viewStats));
+  assert(worldStats.numUpdates == numUpdates);
+  assert(worldStats.numEvents == app.numEvents);
+  assert(worldStats.eventTime >= 0.0);
+
+  uint64_t numViewEvents = 0u;
+  for (size_t i = 0u; i <= PUGL_LOOP_LEAVE; ++i) {
+    numViewEvents += viewStats.numEvents[i];
+  }
+
+  assert(numViewEvents == app.numEvents);
+  assert(viewStats.numEvents[PUGL_CREATE] == 1u);
+  assert(viewStats.numEvents[PUGL_EXPOSE] == app.numExposes);
+  assert(viewStats.numExposes == app.numExposes);
+  assert(viewStats.exposeArea > 0.0);
+  assert(viewStats.numEnters >= app.numExposes);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
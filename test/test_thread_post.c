@@ -0,0 +1,196 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that events and redisplays posted from another thread wake up a
+  blocking update and are all delivered in order, and that a blocking update
+  never stalls while another thread is continuously posting.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NUM_EVENTS 100000u
+#define NUM_STRESS_EVENTS 1000000u
+
+/// Timer to wake up a stalled update, so that the stall can be detected
+static const uintptr_t watchdogId = 1u;
+
+typedef enum {
+  START,
+  EXPOSED,
+  POSTING,
+  FINISHED,
+  STRESSING,
+} State;
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  State           state;
+  size_t          numClients;
+  size_t          numExposes;
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  switch (event->type) {
+  case PUGL_CLIENT:
+    assert(test->state == POSTING || test->state == STRESSING);
+    assert(event->client.data1 == test->numClients);
+    assert(event->client.data2 == ~(uintptr_t)test->numClients);
+    ++test->numClients;
+    break;
+
+  case PUGL_EXPOSE:
+    if (test->state == START) {
+      test->state = EXPOSED;
+    } else if (test->state == POSTING && test->numClients == NUM_EVENTS) {
+      // The redisplay is posted after every client event
+      assert((int)event->expose.x == 8 && (int)event->expose.y == 8);
+      ++test->numExposes;
+      test->state = FINISHED;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static void*
+postEvents(void* data)
+{
+  PuglTest* const test = (PuglTest*)data;
+
+  for (uintptr_t i = 0u; i < NUM_EVENTS; ++i) {
+    const PuglEventClient client = {PUGL_CLIENT, 0, i, ~i};
+
+    // Wait for the main thread to catch up if the queue is full
+    while (puglPostEventFromThread(test->view, (const PuglEvent*)&client)) {
+      sched_yield();
+    }
+  }
+
+  const PuglRect rect = {8, 8, 16, 16};
+  while (puglPostRedisplayFromThread(test->view, rect)) {
+    sched_yield();
+  }
+
+  return NULL;
+}
+
+static void*
+postEventsContinuously(void* data)
+{
+  PuglTest* const test = (PuglTest*)data;
+
+  for (uintptr_t i = 0u; i < NUM_STRESS_EVENTS; ++i) {
+    const PuglEventClient client = {PUGL_CLIENT, 0, i, ~i};
+
+    while (puglPostEventFromThread(test->view, (const PuglEvent*)&client)) {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app = {puglNewWorld(PUGL_PROGRAM, PUGL_WORLD_THREADS),
+                  NULL,
+                  puglParseTestOptions(&argc, &argv),
+                  START,
+                  0u,
+                  0u};
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglStubBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 256, 256);
+
+  // Posting to an unrealized view fails
+  const PuglEventClient client = {PUGL_CLIENT, 0, 0u, 0u};
+  assert(puglPostEventFromThread(app.view, (const PuglEvent*)&client));
+
+  // Create and show window and wait for the initial expose
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  while (app.state != EXPOSED) {
+    assert(!puglUpdate(app.world, -1.0));
+  }
+
+  // Post from another thread and block until everything has arrived
+  pthread_t thread;
+  app.state = POSTING;
+  assert(!pthread_create(&thread, NULL, postEvents, &app));
+  while (app.state != FINISHED) {
+    assert(!puglUpdate(app.world, -1.0));
+  }
+
+  assert(!pthread_join(thread, NULL));
+  assert(app.numClients == NUM_EVENTS);
+  assert(app.numExposes == 1u);
+
+  // Post continuously while blocking, and check that no update ever stalls
+  app.state      = STRESSING;
+  app.numClients = 0u;
+  assert(!puglStartTimer(app.view, watchdogId, 1.0));
+  assert(!pthread_create(&thread, NULL, postEventsContinuously, &app));
+  while (app.numClients < NUM_STRESS_EVENTS) {
+    const double t = puglGetTime(app.world);
+    assert(!puglUpdate(app.world, -1.0));
+    assert(puglGetTime(app.world) - t < 0.5);
+  }
+
+  assert(!pthread_join(thread, NULL));
+  assert(!puglStopTimer(app.view, watchdogId));
+  assert(app.numClients == NUM_STRESS_EVENTS);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+
+  return 0;
+}
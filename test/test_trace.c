@@ -0,0 +1,185 @@
+/*
+  Copyright 2020 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Tests that the trace function is called around properly nested phases, and
+  that the built-in trace file is written as a JSON array.
+*/
+
+#undef NDEBUG
+
+#include "test_utils.h"
+
+#include "pugl/pugl.h"
+#include "pugl/stub.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __APPLE__
+static const double timeout = 1 / 60.0;
+#else
+static const double timeout = -1.0;
+#endif
+
+static const char* const tracePath = "test_trace.json";
+
+#define MAX_DEPTH 8u
+
+typedef struct {
+  PuglWorld*      world;
+  PuglView*       view;
+  PuglTestOptions opts;
+  size_t          numExposes;
+  PuglTracePhase  stack[MAX_DEPTH];
+  size_t          depth;
+  size_t          numPhases[PUGL_TRACE_EVENT + 1];
+} PuglTest;
+
+static PuglStatus
+onEvent(PuglView* view, const PuglEvent* event)
+{
+  PuglTest* test = (PuglTest*)puglGetHandle(view);
+
+  if (test->opts.verbose) {
+    printEvent(event, "Event: ", true);
+  }
+
+  // The event function is always called within an event phase
+  assert(test->depth > 0u);
+  assert(test->stack[test->depth - 1u] == PUGL_TRACE_EVENT);
+
+  if (event->type == PUGL_EXPOSE) {
+    ++test->numExposes;
+  }
+
+  return PUGL_SUCCESS;
+}
+
+static void
+onTrace(PuglWorld*           world,
+        PuglView*            view,
+        const PuglTracePhase phase,
+        const PuglEventType  type,
+        const bool           begin,
+        void*                data)
+{
+  PuglTest* test = (PuglTest*)data;
+
+  assert(world == test->world);
+
+  if (phase >= PUGL_TRACE_ENTER) {
+    assert(view == test->view);
+  } else {
+    assert(!view);
+  }
+
+  if (phase == PUGL_TRACE_EVENT) {
+    assert(type != PUGL_NOTHING);
+  } else {
+    assert(type == PUGL_NOTHING);
+  }
+
+  if (begin) {
+    assert(test->depth < MAX_DEPTH);
+    test->stack[test->depth++] = phase;
+    ++test->numPhases[phase];
+  } else {
+    assert(test->depth > 0u);
+    assert(test->stack[--test->depth] == phase);
+  }
+}
+
+static size_t
+countSubstrings(const char* const string, const char* const substring)
+{
+  size_t      count = 0u;
+  const char* s     = string;
+  while ((s = strstr(s, substring))) {
+    ++count;
+    ++s;
+  }
+
+  return count;
+}
+
+int
+main(int argc, char** argv)
+{
+  PuglTest app;
+  memset(&app, 0, sizeof(app));
+
+  app.world = puglNewWorld(PUGL_PROGRAM, 0);
+  app.opts  = puglParseTestOptions(&argc, &argv);
+
+  // Set up view
+  app.view = puglNewView(app.world);
+  puglSetClassName(app.world, "Pugl Test");
+  puglSetBackend(app.view, puglStubBackend());
+  puglSetHandle(app.view, &app);
+  puglSetEventFunc(app.view, onEvent);
+  puglSetDefaultSize(app.view, 256, 256);
+
+  // Trace creating and showing the window
+  assert(!puglSetTraceFunc(app.world, onTrace, &app));
+  assert(!puglRealize(app.view));
+  assert(!puglShow(app.view));
+  while (!app.numExposes) {
+    assert(!puglUpdate(app.world, timeout));
+  }
+
+  // Check that every phase ended, and that the graphics context was traced
+  assert(app.depth == 0u);
+  assert(app.numPhases[PUGL_TRACE_ENTER] > 0u);
+  assert(app.numPhases[PUGL_TRACE_ENTER] == app.numPhases[PUGL_TRACE_LEAVE]);
+  assert(app.numPhases[PUGL_TRACE_EVENT] > 0u);
+
+  // Write a trace file while redisplaying
+  assert(puglStopTraceFile(app.world) == PUGL_FAILURE);
+  assert(puglStartTraceFile(app.world, "/nonexistent/dir/trace.json"));
+  assert(!puglStartTraceFile(app.world, tracePath));
+  app.numExposes = 0u;
+  assert(!puglPostRedisplay(app.view));
+  while (!app.numExposes) {
+    assert(!puglUpdate(app.world, timeout));
+  }
+  assert(!puglStopTraceFile(app.world));
+
+  // Check that the file is a complete array with matching begins and ends
+  static char buf[1 << 16];
+  FILE* const file = fopen(tracePath, "r");
+  assert(file);
+  const size_t len = fread(buf, 1, sizeof(buf) - 1u, file);
+  assert(!fclose(file));
+  assert(len > 4u && len < sizeof(buf) - 1u);
+  buf[len] = '\0';
+  assert(buf[0] == '[');
+  assert(!strcmp(buf + len - 3u, "\n]\n"));
+  assert(countSubstrings(buf, "\"ph\":\"B\"") > 0u);
+  assert(countSubstrings(buf, "\"ph\":\"B\"") ==
+         countSubstrings(buf, "\"ph\":\"E\""));
+  assert(countSubstrings(buf, "\"name\":\"expose\"") > 0u);
+
+  // Tear down
+  puglFreeView(app.view);
+  puglFreeWorld(app.world);
+  assert(!remove(tracePath));
+
+  return 0;
+}
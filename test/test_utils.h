@@ -263,6 +263,14 @@ puglViewHintString(const PuglViewHint hint)
     return "Ignore key repeat";
   case PUGL_REFRESH_RATE:
     return "Refresh rate";
+  case PUGL_COMPRESS_MOTION:
+    return "Compress motion";
+  case PUGL_RETAIN_CONTENTS:
+    return "Retain contents";
+  case PUGL_SHARE_CONTEXT:
+    return "Share context";
+  case PUGL_STICKY_CONTEXT:
+    return "Sticky context";
   case PUGL_NUM_VIEW_HINTS:
     return "Unknown";
   }